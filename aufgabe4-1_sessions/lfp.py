@@ -46,6 +46,10 @@ Aufgabe41_1LocalizedFlowProbe.setAutoSchedule(True)
 Aufgabe41_1LocalizedFlowProbe.setOption("Step Size", 0.0001)
 Aufgabe41_1LocalizedFlowProbe.setOption("Sample Count", 3)
 Aufgabe41_1LocalizedFlowProbe.setOption("Time", 0)
+Aufgabe41_1LocalizedFlowProbe.setOption("Output Acceleration", True)
+Aufgabe41_1LocalizedFlowProbe.setOption("Output Gradient", True)
+Aufgabe41_1LocalizedFlowProbe.setOption("Output Divergence", True)
+Aufgabe41_1LocalizedFlowProbe.setOption("Output Curvature", True)
 fantom.ui.setAlgorithmPosition(Aufgabe41_1LocalizedFlowProbe, fantom.math.Vector2(0, 142))
 
 # Inbound connections of this algorithm:
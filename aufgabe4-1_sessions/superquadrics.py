@@ -52,6 +52,7 @@ Aufgabe41_2SuperquadricGeneration.setOption("Sample Count", 20)
 Aufgabe41_2SuperquadricGeneration.setOption("Time", 0)
 Aufgabe41_2SuperquadricGeneration.setOption("Normalize to cell", True)
 Aufgabe41_2SuperquadricGeneration.setOption("Cell fill", 1)
+Aufgabe41_2SuperquadricGeneration.setOption("Output Grid", False)
 fantom.ui.setAlgorithmPosition(Aufgabe41_2SuperquadricGeneration, fantom.math.Vector2(0, 142))
 
 # Inbound connections of this algorithm:
@@ -67,9 +68,7 @@ fantom.ui.setAlgorithmPosition(Aufgabe41_3SuperquadricRendering, fantom.math.Vec
 Aufgabe41_3SuperquadricRendering.setVisualOutputVisible('Glyphs', True)
 
 # Inbound connections of this algorithm:
-Aufgabe41_2SuperquadricGeneration.connect("Normals", Aufgabe41_3SuperquadricRendering, "Normals")
-Aufgabe41_2SuperquadricGeneration.connect("Glyph Mesh", Aufgabe41_3SuperquadricRendering, "Grid")
-Aufgabe41_2SuperquadricGeneration.connect("Color", Aufgabe41_3SuperquadricRendering, "Color")
+Aufgabe41_2SuperquadricGeneration.connect("Render Mesh", Aufgabe41_3SuperquadricRendering, "Render Mesh")
 
 # Run the algorithm
 Aufgabe41_3SuperquadricRendering.runBlocking()
@@ -0,0 +1,41 @@
+// Render-ready triangle mesh of SuperquadricTensorGlyphs, uploaded as is by SuperquadricGlyphRenderer.
+
+#pragma once
+
+#include <cstddef>
+#include <fantom/datastructures/DataObject.hpp>
+#include <fantom/graphics.hpp>
+#include <fantom/math.hpp>
+#include <utility>
+#include <vector>
+
+namespace aufgabe4_1
+{
+    // Float positions and normals, per-vertex colors and 32-bit triangle indices in the layout of the graphics buffers,
+    // so the renderer needs no conversion copy. Immutable once built.
+    class GlyphMesh : public fantom::DataObject
+    {
+    public:
+        GlyphMesh( std::vector< fantom::PointF< 3 > > positions, std::vector< fantom::VectorF< 3 > > normals,
+                   std::vector< fantom::Color > colors, std::vector< unsigned int > indices )
+            : mPositions( std::move( positions ) )
+            , mNormals( std::move( normals ) )
+            , mColors( std::move( colors ) )
+            , mIndices( std::move( indices ) )
+        {
+        }
+
+        size_t numVertices() const { return mPositions.size(); }
+        size_t numTriangles() const { return mIndices.size() / 3; }
+        const std::vector< fantom::PointF< 3 > >& positions() const { return mPositions; }
+        const std::vector< fantom::VectorF< 3 > >& normals() const { return mNormals; }
+        const std::vector< fantom::Color >& colors() const { return mColors; }
+        const std::vector< unsigned int >& indices() const { return mIndices; }
+
+    private:
+        std::vector< fantom::PointF< 3 > > mPositions;
+        std::vector< fantom::VectorF< 3 > > mNormals;
+        std::vector< fantom::Color > mColors;
+        std::vector< unsigned int > mIndices;
+    };
+} // namespace aufgabe4_1
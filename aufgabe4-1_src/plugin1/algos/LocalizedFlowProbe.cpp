@@ -1,7 +1,9 @@
 // Localized flow probe (de Leeuw & van Wijk 1993). DataAlgorithm + VisAlgorithm.
 
 #include <algorithm>
+#include <array>
 #include <cmath>
+#include <cstdint>
 #include <fantom/algorithm.hpp>
 #include <fantom/datastructures/interfaces/Field.hpp>
 #include <fantom/datastructures/domains/Grid.hpp>
@@ -12,10 +14,28 @@
 #include <fantom/math.hpp>
 #include <fantom/register.hpp>
 #include <fantom-plugins/utils/Graphics/HelperFunctions.hpp> 
+#include <fantom/datastructures/DataObjectBundle.hpp>
+#include <limits>
+#include <map>
 #include <memory>
+#include <numeric>
+#include <sstream>
 #include <string>
+#include <tuple>
 #include <vector>
 
+#include "ParallelFor.hpp"
+#include "ProbeRecordSet.hpp"
+#include "RectilinearLattice.hpp"
+
+#if defined( __SSE__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 1 )
+#define AUFGABE4_1_SSE 1
+#include <xmmintrin.h>
+#elif defined( __ARM_NEON ) || defined( __ARM_NEON__ )
+#define AUFGABE4_1_NEON 1
+#include <arm_neon.h>
+#endif
+
 namespace aufgabe4_1
 {
     using namespace fantom;
@@ -24,6 +44,113 @@ namespace aufgabe4_1
     {
         constexpr double kMinDirectionNorm = 1e-9;
         constexpr double kDefaultStepSize = 1e-4;
+        constexpr size_t kProbeChunkSize = 64;
+        constexpr size_t kMaxCachedRecords = size_t( 1 ) << 16; // per kernel dimension (a few MB); the cache restarts when full
+
+        // Everything computed for one probe position; valid = inside the field with non-zero velocity.
+        // D = 2 for planar data: only the x/y stencil is evaluated and J is stored as 2x2.
+        template< size_t D >
+        struct ProbeSample
+        {
+            Vector3 velocity;
+            Vector3 acceleration;
+            Tensor< double, D, D > gradient;
+            double divergence = 0.0;
+            Vector3 curvature;
+            bool valid = false;
+        };
+
+        // Derived quantities to compute and publish (velocity always is). J is computed if anything needs it.
+        struct ProbeQuantities
+        {
+            bool acceleration = true;
+            bool gradient = true;
+            bool divergence = true;
+            bool curvature = true;
+
+            bool needGradient() const { return acceleration || gradient || divergence || curvature; }
+            bool needAcceleration() const { return acceleration || curvature; }
+        };
+
+        // Per-execute inputs of the probe kernel besides the evaluator.
+        struct ProbeSetup
+        {
+            std::shared_ptr< const Function< Vector3 > > function;
+            const RectilinearLattice* lattice = nullptr; // set when the analytic gradient is available and only one time is sampled
+            std::vector< double > times;                 // one entry, or the ascending "Time List"
+            double stepSize = kDefaultStepSize;
+            ProbeQuantities quantities;
+        };
+
+        // Ensemble mode: members share the reference grid, so each probe position is located once for all of them.
+        struct EnsembleSetup
+        {
+            std::vector< std::shared_ptr< const Function< Vector3 > > > members; // members[0] is the "Vector Field" input
+            std::vector< std::shared_ptr< const Field< 3, Vector3 > > > fields;  // evaluators, only used without the lattice
+            const RectilinearLattice* lattice = nullptr;
+            double time = 0.0;
+            double stepSize = kDefaultStepSize;
+            ProbeQuantities quantities;
+        };
+
+        // Adaptive placement: the coarse lattice it starts from and the refinement limits.
+        struct RefineSetup
+        {
+            Point3 origin;
+            double spacing = 0.0;
+            std::array< int, 3 > counts = { { 0, 0, 0 } }; // lattice intervals per axis (0 = axis not sampled)
+            int levels = 0;
+            double threshold = 0.0;
+            size_t maxProbes = 0;                          // 0 = no budget
+        };
+
+        // Memo of the expensive per-(position, time) results: v and J (or that the position lies outside the field).
+        template< size_t D >
+        struct ProbeRecord
+        {
+            Vector3 velocity;
+            Tensor< double, D, D > gradient;
+            bool known = false;       // evaluated (false = never reached, e.g. after the probe left the field)
+            bool inside = false;
+            bool hasGradient = false; // J is only computed for valid probes
+        };
+
+        template< size_t D >
+        using ProbeCacheMap = std::map< std::array< double, 4 >, ProbeRecord< D > >;
+
+        // Records are only valid for the field and gradient settings they were computed with.
+        template< size_t D >
+        struct ProbeCache
+        {
+            std::weak_ptr< const Function< Vector3 > > function; // weak, so the cache neither keeps the field alive nor matches a new one at the same address
+            bool analytic = false;
+            double stepSize = 0.0;
+            ProbeCacheMap< D > records;
+        };
+
+        // Exact position: hits only where a re-execute repeats positions (same lattice with other times, refinement or outputs);
+        // a new Sample Count moves the lattice and misses, which is why the cache is opt-in.
+        std::array< double, 4 > probeKey( const Point3& p, double time ) { return { { p[0], p[1], p[2], time } }; }
+
+        // "Time List": numbers separated by commas, semicolons or whitespace; sorted ascending, duplicates removed.
+        std::vector< double > parseTimeList( std::string text )
+        {
+            std::replace( text.begin(), text.end(), ',', ' ' );
+            std::replace( text.begin(), text.end(), ';', ' ' );
+            std::istringstream in( text );
+            std::vector< double > times;
+            std::string token;
+            while( in >> token )
+            {
+                std::istringstream number( token );
+                double t;
+                if( !( number >> t ) || !number.eof() ) throw std::logic_error( "Time List: '" + token + "' is not a number." );
+                times.push_back( t );
+            }
+            std::sort( times.begin(), times.end() );
+            times.erase( std::unique( times.begin(), times.end() ), times.end() );
+            return times;
+        }
 
         // Evaluate velocity at one point; returns zero if point is outside the field.
         Vector3 evaluateField( FieldEvaluator< 3, Vector3 >& evaluator, const Point3& position, double time )
@@ -33,34 +160,59 @@ namespace aufgabe4_1
             return evaluator.value();
         }
 
-        // Jacobian J: how velocity changes in x, y, z. Built from central differences (sample ±h along each axis).
-        Tensor< double, 3, 3 > computeGradient( FieldEvaluator< 3, Vector3 >& evaluator, const Point3& p, double time, double h )
+        template< size_t D >
+        Tensor< double, D, D > zeroTensor()
         {
-            // Central differences
-            Vector3 v_xp = evaluateField( evaluator, p + Vector3( h, 0.0, 0.0 ), time );
-            Vector3 v_xm = evaluateField( evaluator, p - Vector3( h, 0.0, 0.0 ), time );
-            Vector3 dv_dx = ( v_xp - v_xm ) / ( 2.0 * h );
-
-            Vector3 v_yp = evaluateField( evaluator, p + Vector3( 0.0, h, 0.0 ), time );
-            Vector3 v_ym = evaluateField( evaluator, p - Vector3( 0.0, h, 0.0 ), time );
-            Vector3 dv_dy = ( v_yp - v_ym ) / ( 2.0 * h );
-
-            Vector3 v_zp = evaluateField( evaluator, p + Vector3( 0.0, 0.0, h ), time );
-            Vector3 v_zm = evaluateField( evaluator, p - Vector3( 0.0, 0.0, h ), time );
-            Vector3 dv_dz = ( v_zp - v_zm ) / ( 2.0 * h );
+            Tensor< double, D, D > J;
+            for( size_t r = 0; r < D; ++r )
+                for( size_t c = 0; c < D; ++c ) J( r, c ) = 0.0;
+            return J;
+        }
 
+        // Jacobian J: how velocity changes along the first D axes. Built from central differences (sample ±h along each axis).
+        template< size_t D >
+        Tensor< double, D, D > computeGradient( FieldEvaluator< 3, Vector3 >& evaluator, const Point3& p, double time, double h )
+        {
             // J = [dv/dx, dv/dy, dv/dz] (columns)
-            return Tensor< double, 3, 3 >( { dv_dx[0], dv_dy[0], dv_dz[0],
-                                           dv_dx[1], dv_dy[1], dv_dz[1],
-                                           dv_dx[2], dv_dy[2], dv_dz[2] } );
+            Tensor< double, D, D > J = zeroTensor< D >();
+            for( size_t c = 0; c < D; ++c )
+            {
+                Vector3 offset( 0.0, 0.0, 0.0 );
+                offset[c] = h;
+                Vector3 dv = ( evaluateField( evaluator, p + offset, time ) - evaluateField( evaluator, p - offset, time ) ) / ( 2.0 * h );
+                for( size_t r = 0; r < D; ++r ) J( r, c ) = dv[r];
+            }
+            return J;
         }
 
         // Divergence = sum of diagonal of J. Positive = flow spreads out, negative = converges.
-        double computeDivergence( const Tensor< double, 3, 3 >& J )
+        template< size_t D >
+        double computeDivergence( const Tensor< double, D, D >& J )
         {
-            return J(0,0) + J(1,1) + J(2,2);
+            double div = 0.0;
+            for( size_t d = 0; d < D; ++d ) div += J( d, d );
+            return div;
         }
 
+        // Acceleration a = J*v (how velocity changes along the flow); z stays zero for planar probes.
+        template< size_t D >
+        Vector3 computeAcceleration( const Tensor< double, D, D >& J, const Vector3& v )
+        {
+            Vector3 a( 0.0, 0.0, 0.0 );
+            for( size_t r = 0; r < D; ++r )
+                for( size_t c = 0; c < D; ++c ) a[r] += J( r, c ) * v[c];
+            return a;
+        }
+
+        // Planar 2x2 Jacobian embedded in 3x3 (z row and column zero) for code that works in 3D; 3x3 passes through.
+        Tensor< double, 3, 3 > liftGradient( const Tensor< double, 2, 2 >& J )
+        {
+            return Tensor< double, 3, 3 >( { J(0,0), J(0,1), 0.0,
+                                           J(1,0), J(1,1), 0.0,
+                                           0.0,    0.0,    0.0 } );
+        }
+        const Tensor< double, 3, 3 >& liftGradient( const Tensor< double, 3, 3 >& J ) { return J; }
+
         // Rotation (curl): from the off-diagonal entries of J. Measures local spin of the flow.
         Vector3 computeRotation( const Tensor< double, 3, 3 >& J )
         {
@@ -76,6 +228,193 @@ namespace aufgabe4_1
             return aPerp / std::sqrt( uu );
         }
 
+        double curlMagnitude( const Tensor< double, 3, 3 >& J ) { return norm( computeRotation( J ) ); }
+        double curlMagnitude( const Tensor< double, 2, 2 >& J ) { return std::abs( J(1,0) - J(0,1) ); }
+
+        // Features that drive adaptive refinement: |div|, |curl|, |curvature|.
+        template< size_t D >
+        std::array< double, 3 > probeFeatures( const ProbeSample< D >& s )
+        {
+            return { { std::abs( s.divergence ), curlMagnitude( s.gradient ), norm( s.curvature ) } };
+        }
+
+        // dv/dt at time step t from the neighbouring steps (central inside the list, one-sided at its ends).
+        template< size_t D >
+        Vector3 temporalDerivative( const ProbeSample< D >* series, const std::vector< double >& times, size_t t )
+        {
+            size_t lo = ( t > 0 ) ? t - 1 : t;
+            size_t hi = ( t + 1 < times.size() ) ? t + 1 : t;
+            double dt = times[hi] - times[lo];
+            if( hi == lo || dt <= 0.0 ) return Vector3( 0.0, 0.0, 0.0 );
+            Vector3 dvdt = ( series[hi].velocity - series[lo].velocity ) / dt;
+            if( D == 2 ) dvdt[2] = 0.0;
+            return dvdt;
+        }
+
+        // v, J, a = J*v + dv/dt, div and curvature (those in setup.quantities) at p for every time in setup.times (series has one entry per time).
+        // The probe stays invalid if it leaves the field at any time or never moves. With the cache, records (one per time)
+        // receives the expensive part (v, J) and entries found in cache are reused instead of evaluated; both are null
+        // without it. Returns the number of cache hits.
+        template< size_t D >
+        size_t sampleProbe( FieldEvaluator< 3, Vector3 >& evaluator, const ProbeSetup& setup, const Point3& p, ProbeSample< D >* series,
+                            const ProbeCacheMap< D >* cache, ProbeRecord< D >* records )
+        {
+            const auto& times = setup.times;
+            size_t hits = 0;
+            bool moving = false;
+            for( size_t t = 0; t < times.size(); ++t )
+            {
+                ProbeRecord< D > scratch;
+                ProbeRecord< D >& r = records ? records[t] : scratch;
+                auto hit = cache ? cache->find( probeKey( p, times[t] ) ) : typename ProbeCacheMap< D >::const_iterator();
+                if( cache && hit != cache->end() ) { r = hit->second; ++hits; }
+                else
+                {
+                    evaluator.reset( p, times[t] );
+                    r.known = true;
+                    r.inside = static_cast< bool >( evaluator );
+                    if( r.inside ) r.velocity = evaluator.value();
+                }
+                if( !r.inside ) return hits;
+                series[t].velocity = r.velocity;
+                moving = moving || norm( series[t].velocity ) >= kMinDirectionNorm;
+            }
+            if( !moving ) return hits;
+
+            // The analytic J comes from the Function's stored values; execute only sets the lattice for a single time step.
+            const ProbeQuantities& q = setup.quantities;
+            bool located = false, cellDone = false;
+            Tensor< double, D, D > cellGradient;
+            for( size_t t = 0; t < times.size(); ++t )
+            {
+                ProbeRecord< D > scratch;
+                ProbeRecord< D >& r = records ? records[t] : scratch;
+                ProbeSample< D >& s = series[t];
+                s.valid = true;
+                if( !q.needGradient() ) continue;
+                if( !r.hasGradient )
+                {
+                    if( !cellDone )
+                    {
+                        LatticeCell cell;
+                        located = setup.lattice && setup.lattice->locate( p, cell );
+                        if( located ) cellGradient = setup.lattice->jacobian< D >( cell, setup.function->values() );
+                        cellDone = true;
+                    }
+                    r.gradient = located ? cellGradient : computeGradient< D >( evaluator, p, times[t], setup.stepSize );
+                    r.hasGradient = true;
+                }
+
+                s.gradient = r.gradient;
+                if( q.needAcceleration() ) s.acceleration = computeAcceleration( s.gradient, s.velocity ) + temporalDerivative( series, times, t );
+                if( q.divergence ) s.divergence = computeDivergence( s.gradient );
+                if( q.curvature ) s.curvature = computeCurvature( s.velocity, s.acceleration );
+            }
+            return hits;
+        }
+
+        // v, J, a = J*v, div and curvature of every ensemble member at p (members has one entry per member).
+        // With the lattice, p is located once and each member is read from its stored values; otherwise every member's
+        // evaluator locates p itself. All members are valid if p is inside and the reference member moves.
+        template< size_t D >
+        void sampleEnsembleProbe( std::vector< std::unique_ptr< FieldEvaluator< 3, Vector3 > > >& evaluators, const EnsembleSetup& setup,
+                                  const Point3& p, ProbeSample< D >* members )
+        {
+            const size_t n = setup.members.size();
+            LatticeCell cell;
+            if( setup.lattice )
+            {
+                if( !setup.lattice->locate( p, cell ) ) return;
+                for( size_t m = 0; m < n; ++m ) members[m].velocity = setup.lattice->interpolate( cell, setup.members[m]->values() );
+            }
+            else
+            {
+                for( size_t m = 0; m < n; ++m )
+                {
+                    evaluators[m]->reset( p, setup.time );
+                    if( !*evaluators[m] ) return;
+                    members[m].velocity = evaluators[m]->value();
+                }
+            }
+            if( norm( members[0].velocity ) < kMinDirectionNorm ) return;
+
+            // The divergence statistics always need J and div.
+            const ProbeQuantities& q = setup.quantities;
+            for( size_t m = 0; m < n; ++m )
+            {
+                ProbeSample< D >& s = members[m];
+                s.gradient = setup.lattice ? setup.lattice->jacobian< D >( cell, setup.members[m]->values() )
+                                           : computeGradient< D >( *evaluators[m], p, setup.time, setup.stepSize );
+                if( q.needAcceleration() ) s.acceleration = computeAcceleration( s.gradient, s.velocity );
+                s.divergence = computeDivergence( s.gradient );
+                if( q.curvature ) s.curvature = computeCurvature( s.velocity, s.acceleration );
+                s.valid = true;
+            }
+        }
+
+        // Ensemble members must live on the reference grid: the same object, or a grid with identical points (separate loads).
+        bool sameGrid( const Grid< 3 >* other, const Grid< 3 >& grid )
+        {
+            if( !other ) return false;
+            if( other == &grid ) return true;
+            const auto& a = other->points();
+            const auto& b = grid.points();
+            if( a.size() != b.size() ) return false;
+            for( size_t i = 0; i < a.size(); ++i )
+            {
+                const Point3 pa = a[i], pb = b[i];
+                if( pa[0] != pb[0] || pa[1] != pb[1] || pa[2] != pb[2] ) return false;
+            }
+            return true;
+        }
+
+        // FlowProbeRenderer input as plain arrays of count entries: pointers into a ProbeRecordSet, or into the stores below,
+        // filled once from the individual Functions. Pointers refer to this object (which also holds the record set), so it is not copyable.
+        struct ProbeArrays
+        {
+            ProbeArrays() = default;
+            ProbeArrays( const ProbeArrays& ) = delete;
+            ProbeArrays& operator=( const ProbeArrays& ) = delete;
+
+            size_t count = 0;
+            const Point3* positions = nullptr;
+            const Vector3* velocity = nullptr;
+            const Vector3* acceleration = nullptr;
+            const Tensor< double, 3, 3 >* gradient = nullptr;
+            const double* divergence = nullptr;
+            const Vector3* curvature = nullptr;
+            bool hasGradient = false;
+
+            std::vector< Point3 > positionStore;
+            std::vector< Vector3 > velocityStore, accelerationStore, curvatureStore;
+            std::vector< Tensor< double, 3, 3 > > gradientStore;
+            std::vector< double > divergenceStore;
+            std::shared_ptr< const ProbeRecordSet > records; // keeps the arrays behind the pointers alive
+        };
+
+        // Copies the first count values of f into store; entries f does not have (or all, without f) get fallback.
+        template< typename T, typename U, typename Convert >
+        const U* copyValues( const Function< T >* f, size_t count, std::vector< U >& store, const U& fallback, Convert convert )
+        {
+            store.assign( count, fallback );
+            if( f )
+            {
+                const auto& values = f->values();
+                const size_t n = std::min( count, values.size() );
+                for( size_t i = 0; i < n; ++i ) store[i] = convert( values[i] );
+            }
+            return store.data();
+        }
+
+        // Record arrays are used in place; an empty one (quantity not computed) is replaced by store filled with fallback.
+        template< typename T >
+        const T* recordValues( const std::vector< T >& values, size_t count, std::vector< T >& store, const T& fallback )
+        {
+            if( values.size() == count ) return values.data();
+            store.assign( count, fallback );
+            return store.data();
+        }
+
         PointF<3> toPointF( const Point3& p ) { return PointF<3>( (float)p[0], (float)p[1], (float)p[2] ); }
 
         // Distinct color per probe index (golden-ratio hue) so each probe is visually grouped
@@ -95,6 +434,644 @@ namespace aufgabe4_1
             else                       { r = c; g = 0.0f; b = x; }
             return Color( r + m, g + m, b + m, 1.0f );
         }
+
+        constexpr double kKappaEps = 1e-6;
+        constexpr size_t kGlyphChunkSize = 256;
+
+        // Settings of one FlowProbeRenderer run that are the same for every glyph.
+        struct GlyphParams
+        {
+            double scale = 0.5;
+            double tubeLength = 0.2;
+            double ringRad = 0.1; // ring and lens radius
+            double memRad = 0.08;
+            double maxVel = 1.0;
+            bool showTube = true;
+            bool showMembrane = true;
+            bool showLens = true;
+            bool colorByProbeId = true;
+            bool hasGradient = false;
+        };
+
+        // Unit shapes of the glyph parts, built once per renderer: angle tables and index patterns relative to a part's first vertex.
+        struct GlyphTemplate
+        {
+            int arcSegs = 16;
+            int tubeCirc = 10;
+            int ringSegs = 20;
+            int memSegs = 16;
+            int lensRings = 6;
+            int lensSegs = 12;
+            int headSpokes = 8;
+            bool surfaces = true;                   // false: shaft line and ring only (no head, tube, membrane, lens)
+            std::vector< float > tubeCos, tubeSin;  // tubeCirc + 1 (seam vertex repeated)
+            std::vector< float > headCos, headSin;  // headSpokes
+            std::vector< float > ringCos, ringSin;  // ringSegs
+            std::vector< float > memCos, memSin;    // memSegs + 1
+            std::vector< float > lensCos, lensSin;  // lensSegs
+            std::vector< unsigned int > tubeSegment; // triangles between two tube cross-sections
+            std::vector< unsigned int > membrane;    // fan around the centre vertex
+            std::vector< unsigned int > lens;        // apex fan and the bands between rings
+        };
+
+        // cos/sin of k * 2pi / n for k < count.
+        void angleTable( int n, int count, std::vector< float >& c, std::vector< float >& s )
+        {
+            c.resize( count );
+            s.resize( count );
+            for( int k = 0; k < count; ++k )
+            {
+                double ang = k * 2.0 * M_PI / n;
+                c[k] = (float)std::cos( ang );
+                s[k] = (float)std::sin( ang );
+            }
+        }
+
+        GlyphTemplate makeGlyphTemplate( int arcSegs, int tubeCirc, int ringSegs, int memSegs, int lensRings, int lensSegs,
+                                         int headSpokes, bool surfaces )
+        {
+            GlyphTemplate t;
+            t.arcSegs = arcSegs;
+            t.tubeCirc = tubeCirc;
+            t.ringSegs = ringSegs;
+            t.memSegs = memSegs;
+            t.lensRings = lensRings;
+            t.lensSegs = lensSegs;
+            t.headSpokes = headSpokes;
+            t.surfaces = surfaces;
+            angleTable( tubeCirc, tubeCirc + 1, t.tubeCos, t.tubeSin );
+            angleTable( std::max( 1, headSpokes ), headSpokes, t.headCos, t.headSin );
+            angleTable( ringSegs, ringSegs, t.ringCos, t.ringSin );
+            angleTable( memSegs, memSegs + 1, t.memCos, t.memSin );
+            angleTable( lensSegs, lensSegs, t.lensCos, t.lensSin );
+
+            const unsigned int ring = tubeCirc + 1;
+            for( unsigned int k = 0; k < (unsigned int)tubeCirc; ++k )
+            {
+                unsigned int i00 = k, i01 = k + 1, i10 = ring + k, i11 = ring + k + 1;
+                t.tubeSegment.insert( t.tubeSegment.end(), { i00, i01, i10, i01, i11, i10 } );
+            }
+            for( unsigned int k = 0; k < (unsigned int)memSegs; ++k ) t.membrane.insert( t.membrane.end(), { 0u, k + 1, k + 2 } );
+            for( unsigned int seg = 0; seg < (unsigned int)lensSegs; ++seg )
+                t.lens.insert( t.lens.end(), { 0u, 1 + seg, 1 + ( seg + 1 ) % lensSegs } );
+            for( unsigned int r = 0; r + 1 < (unsigned int)lensRings; ++r )
+                for( unsigned int seg = 0; seg < (unsigned int)lensSegs; ++seg )
+                {
+                    unsigned int seg1 = ( seg + 1 ) % lensSegs;
+                    unsigned int a0 = 1 + r * lensSegs + seg, a1 = 1 + r * lensSegs + seg1;
+                    unsigned int b0 = 1 + ( r + 1 ) * lensSegs + seg, b1 = 1 + ( r + 1 ) * lensSegs + seg1;
+                    t.lens.insert( t.lens.end(), { a0, a1, b0, a1, b1, b0 } );
+                }
+            return t;
+        }
+
+        // Compact per-probe glyph record (88 bytes: 84 of floats and colour, the lod byte padded to 4): placement, bending, ring deformation, shape parameters, colour and level of detail.
+        // Sizes that follow from the arc length and GlyphParams are recomputed when the instance is expanded. This is a CPU-side
+        // cache for partial rebuilds only: every instance is expanded into full vertex buffers, so GPU memory per probe is unchanged.
+        struct ProbeInstance
+        {
+            std::array< float, 3 > position;
+            std::array< float, 3 > direction; // T = v / |v|
+            std::array< float, 3 > normal;    // curvature direction N (zero if straight)
+            std::array< float, 3 > ringA;     // ring ellipse axes after the J deformation, radius included
+            std::array< float, 3 > ringB;
+            float kappa;
+            float length;                     // arc length L
+            float torsion;                    // curl . u (stripe frequency)
+            float bulge;                      // membrane bulge along the tip direction (acceleration)
+            float lensHeight;                 // paraboloid height (divergence)
+            std::uint32_t color;              // RGBA8
+            std::uint8_t lod = 0;             // tessellation level (0 = full detail)
+        };
+        static_assert( sizeof( ProbeInstance ) == 88, "ProbeInstance layout changed; update the size above" );
+
+        std::array< float, 3 > toFloat3( const Vector3& v ) { return { { (float)v[0], (float)v[1], (float)v[2] } }; }
+        Vector3 toVector3( const std::array< float, 3 >& v ) { return Vector3( v[0], v[1], v[2] ); }
+
+        std::uint32_t packColor( const Color& c )
+        {
+            auto q = []( float x ) { return (std::uint32_t)std::lround( std::max( 0.0f, std::min( 1.0f, x ) ) * 255.0f ); };
+            return q( c.r() ) | q( c.g() ) << 8 | q( c.b() ) << 16 | q( c.a() ) << 24;
+        }
+
+        Color unpackColor( std::uint32_t c )
+        {
+            return Color( ( c & 255 ) / 255.0f, ( ( c >> 8 ) & 255 ) / 255.0f, ( ( c >> 16 ) & 255 ) / 255.0f, ( c >> 24 ) / 255.0f );
+        }
+
+        // Plane perpendicular to the flow for ring and lens; spanned by the binormal side for curved probes.
+        void ringFrame( const Vector3& dir, const Vector3& N, double kappa, Vector3& right, Vector3& up )
+        {
+            up = Vector3( 0, 0, 1 );
+            if( std::abs( dir[2] ) > 0.9 ) up = Vector3( 0, 1, 0 );
+            right = normalized( cross( dir, up ) );
+            up = normalized( cross( right, dir ) );
+            if( kappa >= kKappaEps ) { right = normalized( cross( dir, N ) ); up = normalized( cross( right, dir ) ); }
+        }
+
+        // Color: by divergence (red = spreading, blue = converging) or one color per probe.
+        Color glyphColor( const ProbeArrays& probes, size_t i, bool byProbeId )
+        {
+            if( byProbeId ) return probeColor( i );
+            double divSat = std::tanh( probes.divergence[i] * 5.0 );
+            return ( divSat > 0 ) ? Color( 1.0f, 1.0f - (float)divSat, 1.0f - (float)divSat )
+                                  : Color( 1.0f + (float)divSat, 1.0f + (float)divSat, 1.0f );
+        }
+
+        // Glyph of probe i; false if it does not move (no direction to draw).
+        bool makeProbeInstance( const ProbeArrays& probes, size_t i, const GlyphParams& params, ProbeInstance& g )
+        {
+            Vector3 v = probes.velocity[i];
+            double vLen = norm( v );
+            if( vLen < kMinDirectionNorm ) return false;
+
+            // Shaft length in "time" units: scaled by speed so faster flow gets a longer arrow.
+            double dt = params.scale * params.tubeLength * ( vLen / params.maxVel );
+            Vector3 a = probes.acceleration[i];
+            const Tensor< double, 3, 3 >& J = probes.gradient[i];
+            double div = probes.divergence[i];
+            Vector3 c = probes.curvature[i];
+
+            Vector3 T = normalized( v );
+            double kappa = norm( c );
+            Vector3 N = ( kappa >= kKappaEps ) ? normalized( c ) : Vector3( 0, 0, 0 );
+
+            // Shear ring: J deforms p + r into p + r + J r dt/2, which is linear in r, so the deformed circle is an
+            // ellipse whose axes are the deformed circle axes.
+            Vector3 ringRight, ringUp;
+            ringFrame( T, N, kappa, ringRight, ringUp );
+            Vector3 A = ringRight * params.ringRad, B = ringUp * params.ringRad;
+            if( params.hasGradient )
+            {
+                A = A + J * A * ( dt * 0.5 );
+                B = B + J * B * ( dt * 0.5 );
+            }
+
+            g.position = toFloat3( probes.positions[i] );
+            g.direction = toFloat3( T );
+            g.normal = toFloat3( N );
+            g.ringA = toFloat3( A );
+            g.ringB = toFloat3( B );
+            g.kappa = (float)kappa;
+            g.length = (float)( vLen * dt );
+            // Curl along flow direction: drives the torsion stripe pattern on the tube.
+            g.torsion = (float)( ( computeRotation( J ) * v ) / vLen );
+            // Acceleration disc at tip; bulge along flow from a.u.
+            g.bulge = (float)( 0.15 * params.scale * std::tanh( ( a * v ) / vLen * 2.0 ) );
+            // Lens height follows divergence (dome or bowl).
+            g.lensHeight = (float)( 0.08 * params.scale * std::tanh( div * 3.0 ) );
+            g.color = packColor( glyphColor( probes, i, params.colorByProbeId ) );
+            return true;
+        }
+
+        // Glyph parts, each rendered (and cached by FlowProbeRenderer) as its own drawable.
+        enum GlyphLayer { ShaftLayer, RingLayer, TubeLayer, MembraneLayer, LensLayer, NumGlyphLayers };
+
+        bool isLineLayer( int layer ) { return layer == ShaftLayer || layer == RingLayer; }
+
+        // Geometry of one layer (colours are computed separately, see layerColors). normals only for triangle layers,
+        // shade (stripe brightness per vertex) only for the tube.
+        struct LayerMesh
+        {
+            std::vector< PointF< 3 > > verts;
+            std::vector< VectorF< 3 > > normals;
+            std::vector< float > shade;
+            std::vector< unsigned int > indices;
+        };
+
+        // Vertex and index count of a glyph in one layer, or (after the prefix sum) where its geometry starts.
+        struct LayerOffsets
+        {
+            size_t vert = 0;
+            size_t index = 0;
+        };
+
+        // Straight glyphs have a two-point shaft, curved ones arcSegs + 1 points.
+        size_t arcPointCount( const ProbeInstance& g, const GlyphTemplate& t )
+        {
+            return ( g.kappa < kKappaEps || g.length < 1e-12 ) ? 2 : t.arcSegs + 1;
+        }
+
+        // Exact buffer use of expandLayer for g.
+        LayerOffsets layerCounts( int layer, const ProbeInstance& g, const GlyphTemplate& t )
+        {
+            const size_t arc = arcPointCount( g, t );
+            LayerOffsets n;
+            switch( layer )
+            {
+            case ShaftLayer: n.vert = arc + t.headSpokes; n.index = 2 * ( ( arc - 1 ) + t.headSpokes ); break;
+            case RingLayer: n.vert = t.ringSegs; n.index = 2 * t.ringSegs; break;
+            case TubeLayer: if( t.surfaces ) { n.vert = arc * ( t.tubeCirc + 1 ); n.index = ( arc - 1 ) * t.tubeSegment.size(); } break;
+            case MembraneLayer: if( t.surfaces ) { n.vert = t.memSegs + 2; n.index = t.membrane.size(); } break;
+            case LensLayer: if( t.surfaces ) { n.vert = 1 + t.lensRings * t.lensSegs; n.index = t.lens.size(); } break;
+            }
+            return n;
+        }
+
+        // Triangles of g in the shown layers (for the budget).
+        size_t glyphTriangles( const ProbeInstance& g, const GlyphTemplate& t, const std::array< bool, NumGlyphLayers >& shown )
+        {
+            size_t n = 0;
+            for( int layer = TubeLayer; layer < NumGlyphLayers; ++layer )
+                if( shown[layer] ) n += layerCounts( layer, g, t ).index / 3;
+            return n;
+        }
+
+        // Level of detail from the glyph's size relative to the scene extent: full detail down to 1/40 of the extent,
+        // shaft line and ring only below 1/300.
+        std::uint8_t glyphLevel( const ProbeInstance& g, const GlyphParams& params, double extent )
+        {
+            static const double kLevelRatios[] = { 1.0 / 40.0, 1.0 / 120.0, 1.0 / 300.0 };
+            const double size = std::max( (double)g.length, 2.0 * params.ringRad );
+            std::uint8_t level = 0;
+            while( level < 3 && size < kLevelRatios[level] * extent ) ++level;
+            return level;
+        }
+
+        // Coarsens glyphs one level per sweep, smallest first, until their triangles fit into maxTriangles
+        // (the last level has none, so the budget can always be met).
+        void applyTriangleBudget( std::vector< ProbeInstance >& instances, const std::vector< GlyphTemplate >& levels,
+                                  const std::array< bool, NumGlyphLayers >& shown, size_t maxTriangles )
+        {
+            auto triangles = [&]( const ProbeInstance& g ) { return glyphTriangles( g, levels[g.lod], shown ); };
+            size_t total = 0;
+            for( const ProbeInstance& g : instances ) total += triangles( g );
+            if( total <= maxTriangles ) return;
+
+            std::vector< size_t > order( instances.size() );
+            std::iota( order.begin(), order.end(), size_t( 0 ) );
+            std::stable_sort( order.begin(), order.end(), [&]( size_t a, size_t b ) { return instances[a].length < instances[b].length; } );
+            const std::uint8_t last = static_cast< std::uint8_t >( levels.size() - 1 );
+            bool changed = true;
+            while( total > maxTriangles && changed )
+            {
+                changed = false;
+                for( size_t idx : order )
+                {
+                    ProbeInstance& g = instances[idx];
+                    if( g.lod == last ) continue;
+                    total -= triangles( g );
+                    ++g.lod;
+                    total += triangles( g );
+                    changed = true;
+                    if( total <= maxTriangles ) break;
+                }
+            }
+        }
+
+        VectorF< 3 > toVectorF( const Vector3& v ) { return VectorF< 3 >( (float)v[0], (float)v[1], (float)v[2] ); }
+
+        // Shaft of a glyph (osculating arc or straight segment) and the frame at its tip, shared by shaft, tube and membrane.
+        struct GlyphShaft
+        {
+            std::vector< Point3 > arcPoints;
+            Point3 tipPos;
+            Vector3 tipDir, right, up;
+        };
+
+        void buildShaft( const ProbeInstance& g, const GlyphTemplate& t, GlyphShaft& shaft )
+        {
+            const Point3 p = toVector3( g.position );
+            const Vector3 T = toVector3( g.direction );
+            const Vector3 N = toVector3( g.normal );
+            const double L = g.length;
+            auto& arcPoints = shaft.arcPoints;
+
+            // Arc of osculating circle (radius 1/kappa, length L); fallback to straight segment.
+            arcPoints.clear();
+            if( arcPointCount( g, t ) == 2 )
+            {
+                arcPoints.push_back( p );
+                arcPoints.push_back( p + T * L );
+            }
+            else
+            {
+                double R = 1.0 / g.kappa;
+                Point3 center = p + R * N;
+                // Equal angle steps: rotate (cos, sin) by the step instead of calling libm per point.
+                const double step = ( L / R ) / t.arcSegs;
+                const double cosStep = std::cos( step ), sinStep = std::sin( step );
+                double c = 1.0, sn = 0.0;
+                for( int s = 0; s <= t.arcSegs; ++s )
+                {
+                    arcPoints.push_back( center + R * ( -c * N + sn * T ) );
+                    const double next = c * cosStep - sn * sinStep;
+                    sn = sn * cosStep + c * sinStep;
+                    c = next;
+                }
+            }
+            // Where the arrow ends and which way it points (for head and membrane).
+            shaft.tipPos = arcPoints.back();
+            shaft.tipDir = normalized( arcPoints.back() - arcPoints[ arcPoints.size() - 2 ] );
+            shaft.up = Vector3( 0, 0, 1 );
+            if( std::abs( shaft.tipDir[2] ) > 0.9 ) shaft.up = Vector3( 0, 1, 0 );
+            shaft.right = normalized( cross( shaft.tipDir, shaft.up ) );
+            shaft.up = normalized( cross( shaft.right, shaft.tipDir ) );
+        }
+
+        static_assert( sizeof( PointF< 3 > ) == 3 * sizeof( float ) && sizeof( VectorF< 3 > ) == 3 * sizeof( float ),
+                       "glyph kernels write vertices as packed float triples" );
+
+        // A circle of vertices in single precision: positions center + ( ax cos_k + ay sin_k ) * radius and normals
+        // normalBase + ( ax cos_k + ay sin_k ) * normalScale, from the template's angle tables.
+        struct CircleFrame
+        {
+            std::array< float, 3 > center = { { 0.0f, 0.0f, 0.0f } };
+            std::array< float, 3 > ax = { { 0.0f, 0.0f, 0.0f } };
+            std::array< float, 3 > ay = { { 0.0f, 0.0f, 0.0f } };
+            std::array< float, 3 > normalBase = { { 0.0f, 0.0f, 0.0f } };
+            float radius = 1.0f;
+            float normalScale = 0.0f;
+        };
+
+#ifdef AUFGABE4_1_SSE
+        // Stores x, y, z of v (w is dropped).
+        inline void storeFloat3( float* out, __m128 v )
+        {
+            _mm_storel_pi( reinterpret_cast< __m64* >( out ), v );
+            _mm_store_ss( out + 2, _mm_movehl_ps( v, v ) );
+        }
+#endif
+
+        // Writes n vertices (and normals, unless null) of the circle as float triples stride floats apart. Inner loop of
+        // every round glyph part: four vertices per step with SSE or NEON, the scalar loop for the rest and on other targets.
+        void circleVertices( const CircleFrame& f, const float* cosT, const float* sinT, size_t n, float* pos, float* normal, size_t stride )
+        {
+            size_t k = 0;
+#ifdef AUFGABE4_1_SSE
+            __m128 ax[3], ay[3], center[3], normalBase[3];
+            for( int d = 0; d < 3; ++d )
+            {
+                ax[d] = _mm_set1_ps( f.ax[d] );
+                ay[d] = _mm_set1_ps( f.ay[d] );
+                center[d] = _mm_set1_ps( f.center[d] );
+                normalBase[d] = _mm_set1_ps( f.normalBase[d] );
+            }
+            const __m128 radius = _mm_set1_ps( f.radius ), normalScale = _mm_set1_ps( f.normalScale );
+            for( ; k + 4 <= n; k += 4 )
+            {
+                const __m128 c = _mm_loadu_ps( cosT + k ), s = _mm_loadu_ps( sinT + k );
+                __m128 dir[3];
+                for( int d = 0; d < 3; ++d ) dir[d] = _mm_add_ps( _mm_mul_ps( ax[d], c ), _mm_mul_ps( ay[d], s ) );
+                // Lanes hold one component of four vertices; transpose to one vertex per register.
+                __m128 v0 = _mm_add_ps( center[0], _mm_mul_ps( dir[0], radius ) );
+                __m128 v1 = _mm_add_ps( center[1], _mm_mul_ps( dir[1], radius ) );
+                __m128 v2 = _mm_add_ps( center[2], _mm_mul_ps( dir[2], radius ) );
+                __m128 v3 = _mm_setzero_ps();
+                _MM_TRANSPOSE4_PS( v0, v1, v2, v3 );
+                storeFloat3( pos + ( k + 0 ) * stride, v0 );
+                storeFloat3( pos + ( k + 1 ) * stride, v1 );
+                storeFloat3( pos + ( k + 2 ) * stride, v2 );
+                storeFloat3( pos + ( k + 3 ) * stride, v3 );
+                if( !normal ) continue;
+                v0 = _mm_add_ps( normalBase[0], _mm_mul_ps( dir[0], normalScale ) );
+                v1 = _mm_add_ps( normalBase[1], _mm_mul_ps( dir[1], normalScale ) );
+                v2 = _mm_add_ps( normalBase[2], _mm_mul_ps( dir[2], normalScale ) );
+                v3 = _mm_setzero_ps();
+                _MM_TRANSPOSE4_PS( v0, v1, v2, v3 );
+                storeFloat3( normal + ( k + 0 ) * stride, v0 );
+                storeFloat3( normal + ( k + 1 ) * stride, v1 );
+                storeFloat3( normal + ( k + 2 ) * stride, v2 );
+                storeFloat3( normal + ( k + 3 ) * stride, v3 );
+            }
+#elif defined( AUFGABE4_1_NEON )
+            if( stride == 3 )
+            {
+                float32x4_t ax[3], ay[3], center[3], normalBase[3];
+                for( int d = 0; d < 3; ++d )
+                {
+                    ax[d] = vdupq_n_f32( f.ax[d] );
+                    ay[d] = vdupq_n_f32( f.ay[d] );
+                    center[d] = vdupq_n_f32( f.center[d] );
+                    normalBase[d] = vdupq_n_f32( f.normalBase[d] );
+                }
+                const float32x4_t radius = vdupq_n_f32( f.radius ), normalScale = vdupq_n_f32( f.normalScale );
+                for( ; k + 4 <= n; k += 4 )
+                {
+                    const float32x4_t c = vld1q_f32( cosT + k ), s = vld1q_f32( sinT + k );
+                    float32x4_t dir[3];
+                    for( int d = 0; d < 3; ++d ) dir[d] = vaddq_f32( vmulq_f32( ax[d], c ), vmulq_f32( ay[d], s ) );
+                    // Registers hold one component of four vertices; vst3q interleaves them into x, y, z triples.
+                    float32x4x3_t v;
+                    for( int d = 0; d < 3; ++d ) v.val[d] = vaddq_f32( center[d], vmulq_f32( dir[d], radius ) );
+                    vst3q_f32( pos + k * 3, v );
+                    if( !normal ) continue;
+                    for( int d = 0; d < 3; ++d ) v.val[d] = vaddq_f32( normalBase[d], vmulq_f32( dir[d], normalScale ) );
+                    vst3q_f32( normal + k * 3, v );
+                }
+            }
+#endif
+            for( ; k < n; ++k )
+                for( int d = 0; d < 3; ++d )
+                {
+                    const float dir = f.ax[d] * cosT[k] + f.ay[d] * sinT[k];
+                    pos[k * stride + d] = f.center[d] + dir * f.radius;
+                    if( normal ) normal[k * stride + d] = f.normalBase[d] + dir * f.normalScale;
+                }
+        }
+
+        // Stripe brightness 0.5 + 0.5 cos( angle_k + phase ) by the angle addition theorem (no libm per vertex).
+        void stripeShade( const float* cosT, const float* sinT, size_t n, double phase, float* out )
+        {
+            const float cosPhase = (float)( 0.5 * std::cos( phase ) ), sinPhase = (float)( 0.5 * std::sin( phase ) );
+            size_t k = 0;
+#ifdef AUFGABE4_1_SSE
+            const __m128 half = _mm_set1_ps( 0.5f ), cp = _mm_set1_ps( cosPhase ), sp = _mm_set1_ps( sinPhase );
+            for( ; k + 4 <= n; k += 4 )
+                _mm_storeu_ps( out + k, _mm_add_ps( half, _mm_sub_ps( _mm_mul_ps( _mm_loadu_ps( cosT + k ), cp ),
+                                                                       _mm_mul_ps( _mm_loadu_ps( sinT + k ), sp ) ) ) );
+#elif defined( AUFGABE4_1_NEON )
+            const float32x4_t half = vdupq_n_f32( 0.5f ), cp = vdupq_n_f32( cosPhase ), sp = vdupq_n_f32( sinPhase );
+            for( ; k + 4 <= n; k += 4 )
+                vst1q_f32( out + k, vaddq_f32( half, vsubq_f32( vmulq_f32( vld1q_f32( cosT + k ), cp ), vmulq_f32( vld1q_f32( sinT + k ), sp ) ) ) );
+#endif
+            for( ; k < n; ++k ) out[k] = 0.5f + ( cosT[k] * cosPhase - sinT[k] * sinPhase );
+        }
+
+        // Writes one glyph into a pre-sized layer mesh, starting at its offsets; indices are absolute.
+        struct LayerWriter
+        {
+            LayerMesh& mesh;
+            LayerOffsets at;
+
+            // Line between two vertices of this glyph (lines share their end points).
+            void segment( size_t a, size_t b )
+            {
+                mesh.indices[at.index++] = (unsigned int)a;
+                mesh.indices[at.index++] = (unsigned int)b;
+            }
+
+            size_t vertex( const Point3& p, const VectorF< 3 >& n )
+            {
+                mesh.verts[at.vert] = toPointF( p );
+                mesh.normals[at.vert] = n;
+                return at.vert++;
+            }
+
+            float* position( size_t v ) { return &mesh.verts[v][0]; }
+            float* normal( size_t v ) { return &mesh.normals[v][0]; }
+
+            // Hands out count vertices for a circle kernel; returns the first.
+            size_t vertices( size_t count )
+            {
+                size_t first = at.vert;
+                at.vert += count;
+                return first;
+            }
+
+            // The template's index pattern, offset to the part's first vertex.
+            void triangles( const std::vector< unsigned int >& pattern, size_t base )
+            {
+                for( unsigned int i : pattern ) mesh.indices[at.index++] = (unsigned int)( base + i );
+            }
+        };
+
+        // Expansion of one instance's layer into the mesh at the given offsets (the only draw path; there is no instanced
+        // drawing). Glyphs only touch their own ranges, so they can be expanded in parallel. shaft is scratch space.
+        void expandLayer( int layer, const ProbeInstance& g, const GlyphTemplate& t, const GlyphParams& params, LayerMesh& mesh,
+                          const LayerOffsets& at, GlyphShaft& shaft )
+        {
+            LayerWriter out{ mesh, at };
+            const Point3 p = toVector3( g.position );
+            const Vector3 T = toVector3( g.direction );
+            const double L = g.length;
+
+            switch( layer )
+            {
+            case ShaftLayer:
+            {
+                buildShaft( g, t, shaft );
+                const auto& arcPoints = shaft.arcPoints;
+                // Polyline over the arc points; the last one is also the tip every head spoke starts from.
+                const size_t arcBase = out.vertices( arcPoints.size() );
+                for( size_t s = 0; s < arcPoints.size(); ++s ) mesh.verts[arcBase + s] = toPointF( arcPoints[s] );
+                for( size_t s = 0; s + 1 < arcPoints.size(); ++s ) out.segment( arcBase + s, arcBase + s + 1 );
+                if( t.headSpokes > 0 )
+                {
+                    // Arrow head: spokes from the tip back to the cone base.
+                    double headSize = std::max( L * 0.25, params.scale * 0.05 );
+                    CircleFrame f;
+                    f.center = toFloat3( shaft.tipPos - shaft.tipDir * headSize );
+                    f.ax = toFloat3( shaft.right );
+                    f.ay = toFloat3( shaft.up );
+                    f.radius = (float)( headSize * 0.5 );
+                    const size_t tip = arcBase + arcPoints.size() - 1;
+                    const size_t spokes = out.vertices( t.headSpokes );
+                    circleVertices( f, t.headCos.data(), t.headSin.data(), t.headSpokes, out.position( spokes ), nullptr, 3 );
+                    for( int k = 0; k < t.headSpokes; ++k ) out.segment( tip, spokes + k );
+                }
+                break;
+            }
+            case RingLayer:
+            {
+                // Shear ring (ellipse from the deformed axes): closed loop, the last segment returns to the first point.
+                CircleFrame f;
+                f.center = g.position;
+                f.ax = g.ringA;
+                f.ay = g.ringB;
+                const size_t first = out.vertices( t.ringSegs );
+                circleVertices( f, t.ringCos.data(), t.ringSin.data(), t.ringSegs, out.position( first ), nullptr, 3 );
+                for( int k = 0; k < t.ringSegs; ++k ) out.segment( first + k, first + ( k + 1 ) % t.ringSegs );
+                break;
+            }
+            case TubeLayer:
+            {
+                // Tube along arc; stripe phase from torsion proxy (curl.u) for candy-stripe effect.
+                if( !t.surfaces ) break;
+                buildShaft( g, t, shaft );
+                const auto& arcPoints = shaft.arcPoints;
+                const size_t ring = t.tubeCirc + 1;
+                CircleFrame f;
+                f.radius = (float)std::max( L * 0.04, params.scale * 0.02 );
+                f.normalScale = 1.0f;
+                size_t tubeBase = out.at.vert;
+                double arcLenSoFar = 0.0;
+                // At each point along the arc we add a circle of vertices (tube cross-section). Tangent and two perpendiculars define the circle.
+                for( size_t s = 0; s < arcPoints.size(); ++s )
+                {
+                    Vector3 tangent = ( s + 1 < arcPoints.size() )
+                        ? normalized( arcPoints[s + 1] - arcPoints[s] )
+                        : normalized( arcPoints[s] - arcPoints[s - 1] );
+                    Vector3 tu( 0, 0, 1 );
+                    if( std::abs( tangent[2] ) > 0.9 ) tu = Vector3( 0, 1, 0 );
+                    Vector3 tx = normalized( cross( tangent, tu ) );
+                    Vector3 ty = normalized( cross( tx, tangent ) );
+                    f.center = toFloat3( arcPoints[s] );
+                    f.ax = toFloat3( tx );
+                    f.ay = toFloat3( ty );
+                    // tx, ty are orthonormal, so the cross-section direction is already the unit normal.
+                    const size_t v = out.vertices( ring );
+                    circleVertices( f, t.tubeCos.data(), t.tubeSin.data(), ring, out.position( v ), out.normal( v ), 3 );
+                    stripeShade( t.tubeCos.data(), t.tubeSin.data(), ring, g.torsion * arcLenSoFar * 2.0, &mesh.shade[v] );
+                    if( s + 1 < arcPoints.size() ) arcLenSoFar += norm( arcPoints[s + 1] - arcPoints[s] );
+                }
+                for( size_t s = 0; s + 1 < arcPoints.size(); ++s ) out.triangles( t.tubeSegment, tubeBase + s * ring );
+                break;
+            }
+            case MembraneLayer:
+            {
+                // Membrane: disc at tip, centre shifted along flow by the acceleration bulge.
+                if( !t.surfaces ) break;
+                buildShaft( g, t, shaft );
+                size_t memBase = out.vertex( shaft.tipPos + shaft.tipDir * g.bulge, toVectorF( shaft.tipDir ) );
+                CircleFrame f;
+                f.center = toFloat3( shaft.tipPos );
+                f.ax = toFloat3( shaft.right );
+                f.ay = toFloat3( shaft.up );
+                f.radius = (float)params.memRad;
+                f.normalBase = toFloat3( -shaft.tipDir );
+                const size_t v = out.vertices( t.memSegs + 1 );
+                circleVertices( f, t.memCos.data(), t.memSin.data(), t.memSegs + 1, out.position( v ), out.normal( v ), 3 );
+                out.triangles( t.membrane, memBase );
+                break;
+            }
+            case LensLayer:
+            {
+                // Lens (paraboloid) at probe base: apex plus rings in the ring plane.
+                if( !t.surfaces ) break;
+                Vector3 ringRight, ringUp;
+                ringFrame( T, toVector3( g.normal ), g.kappa, ringRight, ringUp );
+                const double lensRad = params.ringRad;
+                const double kDiv = g.lensHeight;
+                size_t lensBase = out.vertex( p, toVectorF( T ) );
+                CircleFrame f;
+                f.ax = toFloat3( ringRight );
+                f.ay = toFloat3( ringUp );
+                for( int r = 1; r <= t.lensRings; ++r )
+                {
+                    double rad = ( r * lensRad ) / t.lensRings;
+                    double z = kDiv * ( rad * rad ) / ( lensRad * lensRad + 1e-12 );
+                    double dzdr = ( lensRad > 1e-12 ) ? ( 2.0 * kDiv * rad / ( lensRad * lensRad ) ) : 0.0;
+                    f.center = toFloat3( p + T * z );
+                    f.radius = (float)rad;
+                    // The radial direction is a unit vector perpendicular to T, so |radial - T dz/dr| = sqrt( 1 + (dz/dr)^2 ) on the whole ring.
+                    const double inv = 1.0 / std::sqrt( 1.0 + dzdr * dzdr );
+                    f.normalBase = toFloat3( ( rad > 1e-12 ) ? Vector3( -T * ( dzdr * inv ) ) : T );
+                    f.normalScale = ( rad > 1e-12 ) ? (float)inv : 0.0f;
+                    const size_t v = out.vertices( t.lensSegs );
+                    circleVertices( f, t.lensCos.data(), t.lensSin.data(), t.lensSegs, out.position( v ), out.normal( v ), 3 );
+                }
+                out.triangles( t.lens, lensBase );
+                break;
+            }
+            }
+        }
+
+        // Vertex colours of glyphs [begin, end) in one layer: the glyph colour (grey rings unless coloured by probe),
+        // times the stripe shade on the tube. firstVertex holds each glyph's first vertex plus the total.
+        void layerColors( int layer, const std::vector< ProbeInstance >& instances, const std::vector< size_t >& firstVertex,
+                          const std::vector< float >& shade, const GlyphParams& params, size_t begin, size_t end,
+                          std::vector< Color >& colors )
+        {
+            for( size_t i = begin; i < end; ++i )
+            {
+                Color color = unpackColor( instances[i].color );
+                if( layer == RingLayer && !params.colorByProbeId ) color = Color( 0.2f, 0.2f, 0.2f );
+                for( size_t v = firstVertex[i]; v < firstVertex[i + 1]; ++v )
+                    colors[v] = ( layer == TubeLayer ) ? Color( shade[v] * color.r(), shade[v] * color.g(), shade[v] * color.b(), 1.0f )
+                                                       : color;
+            }
+        }
     }
 
     class LocalizedFlowProbe : public DataAlgorithm
@@ -105,9 +1082,23 @@ namespace aufgabe4_1
             Options( fantom::Options::Control& control ) : DataAlgorithm::Options( control )
             {
                 add< Field< 3, Vector3 > >( "Vector Field", "Input flow field", Options::REQUIRED );
-                add< double >( "Step Size", "Finite difference step", kDefaultStepSize );
+                add< PointSet< 3 > >( "Seed Points", "Probe these positions instead of the Sample Count lattice (optional)" );
+                add< DataObjectBundle >( "Ensemble Fields", "Further ensemble members on the grid of 'Vector Field' (optional)" );
+                add< double >( "Step Size", "Finite difference step (only used without analytic gradient)", kDefaultStepSize );
+                add< bool >( "Analytic Gradient", "Differentiate the trilinear cell basis on rectilinear grids (exact for trilinear interpolation); off = central differences", false );
                 add< int >( "Sample Count", "Probes per axis (2–3 = clear arrows; 5+ = dense)", 3 );
+                add< bool >( "Adaptive Placement", "Refine the Sample Count lattice where |div|, |curl| or curvature vary strongly", false );
+                add< int >( "Refinement Levels", "Subdivision levels of adaptive placement", 2 );
+                add< double >( "Refinement Threshold", "Relative feature variation inside a cell that triggers subdivision (0–1)", 0.25 );
+                add< int >( "Max Probes", "Budget for adaptive placement, coarse lattice included (0 = no limit)", 0 );
                 add< double >( "Time", "Evaluation time", 0.0 );
+                add< std::string >( "Time List", "Times for one batch run, e.g. '0, 0.5, 1' (empty = only 'Time')", "" );
+                add< int >( "Threads", "Worker threads for probe sampling (0 = all cores, 1 = serial)", 0 );
+                add< bool >( "Cache Probes", "Reuse v and J of earlier runs at the same positions, e.g. when only Time List, refinement or outputs change", false );
+                add< bool >( "Output Acceleration", "Compute and publish the acceleration (off = skipped)", true );
+                add< bool >( "Output Gradient", "Compute and publish the gradient (off = skipped)", true );
+                add< bool >( "Output Divergence", "Compute and publish the divergence (off = skipped)", true );
+                add< bool >( "Output Curvature", "Compute and publish the curvature (off = skipped)", true );
             }
         };
 
@@ -116,11 +1107,19 @@ namespace aufgabe4_1
             DataOutputs( fantom::DataOutputs::Control& control ) : DataAlgorithm::DataOutputs( control )
             {
                 add< const PointSet< 3 > >( "Probe Points" );
+                add< const ProbeRecordSet >( "Probe Records" );
                 add< const Function< Vector3 > >( "Velocity" );
                 add< const Function< Vector3 > >( "Acceleration" );
                 add< const Function< Tensor< double, 3, 3 > > >( "Gradient" );
+                add< const Function< Tensor< double, 2, 2 > > >( "Gradient 2D" );
                 add< const Function< double > >( "Divergence" );
                 add< const Function< Vector3 > >( "Curvature" );
+                add< const DataObjectBundle >( "Time Series" );
+                add< const DataObjectBundle >( "Ensemble Members" );
+                add< const Function< Vector3 > >( "Mean Velocity" );
+                add< const Function< double > >( "Velocity Variance" );
+                add< const Function< double > >( "Mean Divergence" );
+                add< const Function< double > >( "Divergence Variance" );
             }
         };
 
@@ -145,93 +1144,485 @@ namespace aufgabe4_1
                  throw std::logic_error( "Field not on a grid." );
             }
 
-            // Evaluator lets us ask "what is the velocity at this point?"
-            auto evaluator = field->makeEvaluator();
-            if( !evaluator ) { clearResults(); return; }
-
-            double time = options.get< double >( "Time" );
-            double stepSize = options.get< double >( "Step Size" );
+            ProbeSetup setup;
+            setup.function = function;
+            setup.times = parseTimeList( options.get< std::string >( "Time List" ) );
+            if( setup.times.empty() ) setup.times.push_back( options.get< double >( "Time" ) );
+            else debugLog() << "Time List: " << setup.times.size() << " time steps from " << setup.times.front() << " to " << setup.times.back() << std::endl;
+            setup.stepSize = options.get< double >( "Step Size" );
+            setup.quantities.acceleration = options.get< bool >( "Output Acceleration" );
+            setup.quantities.gradient = options.get< bool >( "Output Gradient" );
+            setup.quantities.divergence = options.get< bool >( "Output Divergence" );
+            setup.quantities.curvature = options.get< bool >( "Output Curvature" );
             int sampleCount = std::max( 1, options.get< int >( "Sample Count" ) );
 
-            // Find the box that contains all grid points (min and max x, y, z).
-            const auto& gridPoints = grid->points();
-            if( gridPoints.size() == 0 ) { clearResults(); return; }
-            Point3 gridMin = gridPoints[0], gridMax = gridPoints[0];
-            for( size_t i = 1; i < gridPoints.size(); ++i )
-                for( int d = 0; d < 3; ++d ) {
-                    gridMin[d] = std::min( gridMin[d], gridPoints[i][d] );
-                    gridMax[d] = std::max( gridMax[d], gridPoints[i][d] );
+            // Rectilinear grid with point data: J comes from the cell basis (one location, no step size); otherwise central differences.
+            // The stored values are a single snapshot, so with a Time List J is taken per time step from the stencil instead.
+            RectilinearLattice lattice;
+            const bool onLattice = function->values().size() == grid->points().size() && lattice.build( grid->points() );
+            const RectilinearLattice* analyticLattice = ( onLattice && options.get< bool >( "Analytic Gradient" ) ) ? &lattice : nullptr;
+            if( analyticLattice && setup.times.size() > 1 ) debugLog() << "Analytic Gradient ignored with Time List." << std::endl;
+            else setup.lattice = analyticLattice;
+            debugLog() << "Gradient: " << ( setup.lattice ? "analytic (trilinear cell basis)" : "central differences" ) << std::endl;
+
+            // Seed points replace the lattice: no bounding box, no refinement, one batch over the given positions.
+            auto seeds = options.get< PointSet< 3 > >( "Seed Points" );
+            std::vector< Point3 > positions;
+            RefineSetup refine;
+            const RefineSetup* adaptive = nullptr;
+            bool planar = false;
+            mUseCache = options.get< bool >( "Cache Probes" );
+            if( !mUseCache ) { std::get< ProbeCache< 2 > >( mCaches ).records.clear(); std::get< ProbeCache< 3 > >( mCaches ).records.clear(); }
+            if( seeds )
+            {
+                const auto& seedPoints = seeds->points();
+                positions.reserve( seedPoints.size() );
+                for( size_t i = 0; i < seedPoints.size(); ++i ) positions.push_back( seedPoints[i] );
+                if( positions.empty() ) { clearResults(); return; }
+                // Only a detected single-layer lattice proves the data is planar; scattered seeds alone do not.
+                planar = onLattice && lattice.size( 2 ) == 1;
+                if( options.get< bool >( "Adaptive Placement" ) ) debugLog() << "Adaptive Placement ignored with Seed Points." << std::endl;
+                debugLog() << "Seed Points: " << positions.size() << " probes." << std::endl;
+            }
+            else
+            {
+                // Find the box that contains all grid points (min and max x, y, z).
+                const auto& gridPoints = grid->points();
+                if( gridPoints.size() == 0 ) { clearResults(); return; }
+                Point3 gridMin = gridPoints[0], gridMax = gridPoints[0];
+                for( size_t i = 1; i < gridPoints.size(); ++i )
+                    for( int d = 0; d < 3; ++d ) {
+                        gridMin[d] = std::min( gridMin[d], gridPoints[i][d] );
+                        gridMax[d] = std::max( gridMax[d], gridPoints[i][d] );
+                    }
+
+                debugLog() << "Grid Bounds: Min=" << gridMin << ", Max=" << gridMax << std::endl;
+
+                // Distance between probe positions. If a dimension has zero size we don't sample along it.
+                Vector3 gridSize = gridMax - gridMin;
+                double maxDim = std::max( { gridSize[0], gridSize[1], gridSize[2] } );
+                double spacing = maxDim / static_cast< double >( sampleCount + 1 );
+                int countX = ( gridSize[0] < 1e-6 ) ? 0 : sampleCount;
+                int countY = ( gridSize[1] < 1e-6 ) ? 0 : sampleCount;
+                int countZ = ( gridSize[2] < 1e-6 ) ? 0 : sampleCount;
+
+                debugLog() << "Sampling Grid: " << (countX+1) << "x" << (countY+1) << "x" << (countZ+1) << " probes. Spacing: " << spacing << std::endl;
+
+                positions.reserve( ( countX + 1 ) * ( countY + 1 ) * ( countZ + 1 ) );
+                for( int i = 0; i <= countX; ++i )
+                    for( int j = 0; j <= countY; ++j )
+                        for( int k = 0; k <= countZ; ++k )
+                            positions.push_back( Point3( gridMin[0] + i*spacing, gridMin[1] + j*spacing, gridMin[2] + k*spacing ) );
+
+                refine.origin = gridMin;
+                refine.spacing = spacing;
+                refine.counts = { { countX, countY, countZ } };
+                refine.levels = std::max( 0, std::min( 10, options.get< int >( "Refinement Levels" ) ) );
+                refine.threshold = std::max( 0.0, options.get< double >( "Refinement Threshold" ) );
+                refine.maxProbes = static_cast< size_t >( std::max( 0, options.get< int >( "Max Probes" ) ) );
+                if( options.get< bool >( "Adaptive Placement" ) && refine.levels > 0 ) adaptive = &refine;
+                planar = countZ == 0;
+            }
+
+            // Ensemble mode: "Vector Field" is member 0 and the bundle holds the others; one traversal probes all of them.
+            if( auto ensemble = options.get< DataObjectBundle >( "Ensemble Fields" ) )
+            {
+                EnsembleSetup members;
+                members.members.push_back( function );
+                members.fields.push_back( field );
+                bool pointData = analyticLattice != nullptr;
+                for( size_t i = 0; i < ensemble->size(); ++i )
+                {
+                    auto memberFunction = std::dynamic_pointer_cast< const Function< Vector3 > >( ensemble->getContent( i ) );
+                    auto memberField = std::dynamic_pointer_cast< const Field< 3, Vector3 > >( ensemble->getContent( i ) );
+                    if( !memberFunction || !memberField
+                        || !sameGrid( std::dynamic_pointer_cast< const Grid< 3 > >( memberFunction->domain() ).get(), *grid ) )
+                        throw std::logic_error( "Ensemble member '" + ensemble->getName( i ) + "' is not a vector field on the grid of 'Vector Field'." );
+                    pointData = pointData && memberFunction->values().size() == grid->points().size();
+                    members.members.push_back( memberFunction );
+                    members.fields.push_back( memberField );
                 }
-            
-            debugLog() << "Grid Bounds: Min=" << gridMin << ", Max=" << gridMax << std::endl;
-
-            // Distance between probe positions. If a dimension has zero size we don't sample along it.
-            Vector3 gridSize = gridMax - gridMin;
-            double maxDim = std::max( { gridSize[0], gridSize[1], gridSize[2] } );
-            double spacing = maxDim / static_cast< double >( sampleCount + 1 );
-            int countX = ( gridSize[0] < 1e-6 ) ? 0 : sampleCount;
-            int countY = ( gridSize[1] < 1e-6 ) ? 0 : sampleCount;
-            int countZ = ( gridSize[2] < 1e-6 ) ? 0 : sampleCount;
-            
-            debugLog() << "Sampling Grid: " << (countX+1) << "x" << (countY+1) << "x" << (countZ+1) << " probes. Spacing: " << spacing << std::endl;
+                members.lattice = pointData ? analyticLattice : nullptr;
+                members.time = setup.times.front();
+                members.stepSize = setup.stepSize;
+                members.quantities = setup.quantities;
+                if( setup.times.size() > 1 ) debugLog() << "Ensemble mode samples only t=" << members.time << "." << std::endl;
+                if( adaptive ) debugLog() << "Adaptive Placement ignored in ensemble mode." << std::endl;
 
-            std::vector< Point3 > points;
-            std::vector< Vector3 > velocity;
-            std::vector< Vector3 > acceleration;
-            std::vector< Tensor< double, 3, 3 > > gradient;
-            std::vector< double > divergence;
-            std::vector< Vector3 > curvature;
-
-            // Sample grid; at each point get v, J, a, div, curvature (skip zero velocity).
-            Algorithm::Progress progress( *this, "Sampling Field", (countX+1)*(countY+1)*(countZ+1) );
-            size_t pIdx = 0;
-
-            for( int i = 0; i <= countX; ++i )
-                for( int j = 0; j <= countY; ++j )
-                    for( int k = 0; k <= countZ; ++k )
+                const size_t numThreads = resolveThreadCount( options.get< int >( "Threads" ), positions.size(), kProbeChunkSize );
+                debugLog() << "Ensemble: " << members.members.size() << " members, " << numThreads << " thread(s)." << std::endl;
+                if( planar ) runEnsemble< 2 >( positions, members, numThreads, abortFlag );
+                else runEnsemble< 3 >( positions, members, numThreads, abortFlag );
+                debugLog() << "Finished LocalizedFlowProbe Calculation." << std::endl;
+                return;
+            }
+
+            // One evaluator per worker thread.
+            const size_t numThreads = resolveThreadCount( options.get< int >( "Threads" ), positions.size(), kProbeChunkSize );
+            Evaluators evaluators;
+            for( size_t t = 0; t < numThreads; ++t )
+            {
+                evaluators.push_back( field->makeEvaluator() );
+                if( !evaluators.back() ) { clearResults(); return; }
+            }
+            debugLog() << "Sampling with " << numThreads << " thread(s)." << std::endl;
+
+            // Planar data (no z extent): 2D kernel without the z stencil and with 2x2 Jacobians.
+            if( planar )
+            {
+                debugLog() << "Planar domain: using the 2D probe kernel." << std::endl;
+                runProbes< 2 >( std::move( positions ), setup, adaptive, evaluators, abortFlag );
+            }
+            else runProbes< 3 >( std::move( positions ), setup, adaptive, evaluators, abortFlag );
+
+            debugLog() << "Finished LocalizedFlowProbe Calculation." << std::endl;
+        }
+
+    private:
+        using Evaluators = std::vector< std::unique_ptr< FieldEvaluator< 3, Vector3 > > >;
+
+        // Probe results of earlier executions (one cache per kernel dimension), see runProbes.
+        std::tuple< ProbeCache< 2 >, ProbeCache< 3 > > mCaches;
+        bool mUseCache = false;
+
+        // Samples the probe positions (lattice or seeds, optionally refined adaptively) and publishes the valid ones in input order.
+        template< size_t D >
+        void runProbes( std::vector< Point3 > positions, const ProbeSetup& setup, const RefineSetup* adaptive,
+                        Evaluators& evaluators, const volatile bool& abortFlag )
+        {
+            // Start over when the field or the way J is computed changed.
+            auto& cache = std::get< ProbeCache< D > >( mCaches );
+            const bool analytic = setup.lattice != nullptr;
+            if( cache.function.lock() != setup.function || cache.analytic != analytic || cache.stepSize != setup.stepSize )
+            {
+                cache.records.clear();
+                cache.function = setup.function;
+                cache.analytic = analytic;
+                cache.stepSize = setup.stepSize;
+            }
+
+            // Refinement scores cells by div, curl and curvature, so it computes every quantity; only the requested ones are published.
+            ProbeSetup sampling = setup;
+            if( adaptive ) sampling.quantities = ProbeQuantities();
+            std::vector< ProbeSample< D > > samples;
+            if( !sampleProbes( positions, samples, sampling, evaluators, abortFlag, "Sampling Field" ) ) return;
+            if( adaptive && !refineProbes( *adaptive, positions, samples, sampling, evaluators, abortFlag ) ) return;
+
+            std::vector< std::string > slots;
+            for( double time : setup.times )
+            {
+                std::ostringstream label;
+                label << "t=" << time;
+                slots.push_back( label.str() );
+            }
+            publishProbes( positions, samples, slots, "Time Series", setup.quantities );
+        }
+
+        // Probes every ensemble member at every position in one traversal, then publishes member 0 as the plain outputs,
+        // all members in "Ensemble Members", and mean and (population) variance of velocity and divergence.
+        template< size_t D >
+        void runEnsemble( const std::vector< Point3 >& positions, const EnsembleSetup& setup, size_t numThreads, const volatile bool& abortFlag )
+        {
+            const size_t n = setup.members.size();
+            std::vector< Evaluators > evaluators( numThreads );
+            if( !setup.lattice )
+                for( auto& threadEvaluators : evaluators )
+                    for( const auto& member : setup.fields )
+                    {
+                        threadEvaluators.push_back( member->makeEvaluator() );
+                        if( !threadEvaluators.back() ) { clearResults(); return; }
+                    }
+
+            std::vector< ProbeSample< D > > samples( positions.size() * n );
+            Algorithm::Progress progress( *this, "Sampling Ensemble", positions.size() );
+            parallelFor( positions.size(), numThreads, kProbeChunkSize, abortFlag,
+                [&]( size_t thread, size_t begin, size_t end ) {
+                    for( size_t idx = begin; idx < end && !abortFlag; ++idx )
+                        sampleEnsembleProbe( evaluators[thread], setup, positions[idx], &samples[idx * n] );
+                },
+                [&]( size_t done ) { progress = done; } );
+            if( abortFlag ) return;
+
+            std::vector< std::string > slots;
+            for( size_t m = 0; m < n; ++m ) slots.push_back( "member " + std::to_string( m ) );
+            auto pointSet = publishProbes( positions, samples, slots, "Ensemble Members", setup.quantities );
+            if( !pointSet ) return;
+
+            std::vector< Vector3 > meanVelocity;
+            std::vector< double > velocityVariance, meanDivergence, divergenceVariance;
+            for( size_t idx = 0; idx < positions.size(); ++idx )
+            {
+                const ProbeSample< D >* s = &samples[idx * n];
+                if( !s[0].valid ) continue;
+                Vector3 v( 0.0, 0.0, 0.0 );
+                double div = 0.0;
+                for( size_t m = 0; m < n; ++m ) { v += s[m].velocity; div += s[m].divergence; }
+                v = v / static_cast< double >( n );
+                div /= static_cast< double >( n );
+                double vv = 0.0, dd = 0.0;
+                for( size_t m = 0; m < n; ++m )
+                {
+                    Vector3 dv = s[m].velocity - v;
+                    vv += dv * dv;
+                    dd += ( s[m].divergence - div ) * ( s[m].divergence - div );
+                }
+                meanVelocity.push_back( v );
+                velocityVariance.push_back( vv / static_cast< double >( n ) );
+                meanDivergence.push_back( div );
+                divergenceVariance.push_back( dd / static_cast< double >( n ) );
+            }
+            setResult( "Mean Velocity", fantom::addData( pointSet, PointSet< 3 >::Points, meanVelocity ) );
+            setResult( "Velocity Variance", fantom::addData( pointSet, PointSet< 3 >::Points, velocityVariance ) );
+            if( !setup.quantities.divergence ) return;
+            setResult( "Mean Divergence", fantom::addData( pointSet, PointSet< 3 >::Points, meanDivergence ) );
+            setResult( "Divergence Variance", fantom::addData( pointSet, PointSet< 3 >::Points, divergenceVariance ) );
+        }
+
+        // Samples positions[samples.size() / #times ..] at all times (one evaluator per thread, results by index).
+        // The cache is only read while the workers run; their new records are merged afterwards. Returns false if aborted.
+        template< size_t D >
+        bool sampleProbes( const std::vector< Point3 >& positions, std::vector< ProbeSample< D > >& samples, const ProbeSetup& setup,
+                           Evaluators& evaluators, const volatile bool& abortFlag, const std::string& label )
+        {
+            const size_t numTimes = setup.times.size();
+            const size_t first = samples.size() / numTimes;
+            samples.resize( positions.size() * numTimes );
+            auto& cache = std::get< ProbeCache< D > >( mCaches );
+            const ProbeCacheMap< D >* lookup = mUseCache && !cache.records.empty() ? &cache.records : nullptr;
+            std::vector< ProbeRecord< D > > records( mUseCache ? ( positions.size() - first ) * numTimes : 0 );
+            std::vector< size_t > hits( evaluators.size(), 0 );
+
+            Algorithm::Progress progress( *this, label, positions.size() - first );
+            parallelFor( positions.size() - first, evaluators.size(), kProbeChunkSize, abortFlag,
+                [&]( size_t thread, size_t begin, size_t end ) {
+                    for( size_t idx = first + begin; idx < first + end && !abortFlag; ++idx )
+                        hits[thread] += sampleProbe( *evaluators[thread], setup, positions[idx], &samples[idx * numTimes],
+                                                     lookup, mUseCache ? &records[( idx - first ) * numTimes] : nullptr );
+                },
+                [&]( size_t done ) { progress = done; } );
+            if( abortFlag ) return false;
+
+            if( mUseCache )
+            {
+                // A batch larger than the cap is not cached at all; otherwise a full cache restarts with it.
+                if( records.size() > kMaxCachedRecords ) debugLog() << "Probe cache: " << records.size() << " samples exceed the cache size, not cached." << std::endl;
+                else
+                {
+                    if( cache.records.size() + records.size() > kMaxCachedRecords ) cache.records.clear();
+                    for( size_t i = 0; i < records.size(); ++i )
+                        if( records[i].known ) cache.records[probeKey( positions[first + i / numTimes], setup.times[i % numTimes] )] = records[i];
+                }
+                size_t reused = std::accumulate( hits.begin(), hits.end(), size_t( 0 ) );
+                debugLog() << "Probe cache: " << reused << " of " << records.size() << " sample(s) reused, "
+                           << cache.records.size() << " cached." << std::endl;
+            }
+            return true;
+        }
+
+        // Adaptive placement: subdivides lattice cells whose valid corners differ strongly in |div|, |curl| or |curvature|
+        // (relative to the range over all probes), strongest first, level by level until the levels or the probe budget run out.
+        // New probes are appended after the coarse lattice. Returns false if aborted.
+        template< size_t D >
+        bool refineProbes( const RefineSetup& refine, std::vector< Point3 >& positions, std::vector< ProbeSample< D > >& samples,
+                           const ProbeSetup& setup, Evaluators& evaluators, const volatile bool& abortFlag )
+        {
+            // Integer lattice keys at the finest level, so shared corners of neighbouring cells are sampled once.
+            using Key = std::array< long long, 3 >;
+            struct Cell { Key origin; long long size; };
+            const long long scale = 1LL << refine.levels;
+            const size_t numTimes = setup.times.size();
+
+            std::map< Key, size_t > index;
+            std::vector< Cell > cells;
+            size_t idx = 0;
+            for( int i = 0; i <= refine.counts[0]; ++i )
+                for( int j = 0; j <= refine.counts[1]; ++j )
+                    for( int k = 0; k <= refine.counts[2]; ++k, ++idx )
                     {
-                        progress = ++pIdx;
-                        if( abortFlag ) return;
+                        index[ Key{ { i * scale, j * scale, k * scale } } ] = idx;
+                        bool inner = ( i < refine.counts[0] || refine.counts[0] == 0 ) && ( j < refine.counts[1] || refine.counts[1] == 0 )
+                                  && ( k < refine.counts[2] || refine.counts[2] == 0 );
+                        if( inner ) cells.push_back( { Key{ { i * scale, j * scale, k * scale } }, scale } );
+                    }
 
-                        // Position of this probe in 3D.
-                        Point3 p( gridMin[0] + i*spacing, gridMin[1] + j*spacing, gridMin[2] + k*spacing );
+            auto position = [&]( const Key& key ) {
+                Point3 p;
+                for( int d = 0; d < 3; ++d ) p[d] = refine.origin[d] + ( static_cast< double >( key[d] ) / scale ) * refine.spacing;
+                return p;
+            };
+            // Offsets of the sampled axes only (planar or line-shaped lattices have fewer corners).
+            auto forEachOffset = [&]( int steps, long long step, auto&& fn ) {
+                Key o = { { 0, 0, 0 } };
+                const int n[3] = { refine.counts[0] ? steps : 1, refine.counts[1] ? steps : 1, refine.counts[2] ? steps : 1 };
+                for( int a = 0; a < n[0]; ++a )
+                    for( int b = 0; b < n[1]; ++b )
+                        for( int c = 0; c < n[2]; ++c ) { o = { { a * step, b * step, c * step } }; fn( o ); }
+            };
 
-                        evaluator->reset( p, time );
-                        if( !*evaluator ) continue;
+            // Feature ranges over the coarse probes normalise the per-cell variation.
+            std::array< double, 3 > lo, hi, range;
+            lo.fill( std::numeric_limits< double >::max() );
+            hi.fill( std::numeric_limits< double >::lowest() );
+            for( size_t i = 0; i < positions.size(); ++i )
+            {
+                if( !samples[i * numTimes].valid ) continue;
+                auto f = probeFeatures( samples[i * numTimes] );
+                for( int m = 0; m < 3; ++m ) { lo[m] = std::min( lo[m], f[m] ); hi[m] = std::max( hi[m], f[m] ); }
+            }
+            for( int m = 0; m < 3; ++m ) range[m] = ( hi[m] > lo[m] ) ? hi[m] - lo[m] : 0.0;
 
-                        Vector3 v = evaluator->value();
-                        if( norm( v ) < kMinDirectionNorm ) continue;
+            const size_t coarse = positions.size();
+            if( refine.maxProbes && coarse >= refine.maxProbes )
+                debugLog() << "Max Probes (" << refine.maxProbes << ") already used by the coarse lattice; no refinement." << std::endl;
 
-                        // Gradient J and acceleration a = J*v (how velocity changes along the flow).
-                        auto J = computeGradient( *evaluator, p, time, stepSize );
-                        Vector3 a = J * v; 
+            bool budgetLeft = !refine.maxProbes || coarse < refine.maxProbes;
+            for( int level = 1; level <= refine.levels && budgetLeft && !cells.empty(); ++level )
+            {
+                // Score: largest relative feature variation among the valid corners of each cell.
+                std::vector< std::pair< double, size_t > > scored;
+                for( size_t c = 0; c < cells.size(); ++c )
+                {
+                    std::array< double, 3 > fMin, fMax;
+                    fMin.fill( std::numeric_limits< double >::max() );
+                    fMax.fill( std::numeric_limits< double >::lowest() );
+                    int validCorners = 0;
+                    forEachOffset( 2, cells[c].size, [&]( const Key& o ) {
+                        Key key = { { cells[c].origin[0] + o[0], cells[c].origin[1] + o[1], cells[c].origin[2] + o[2] } };
+                        const ProbeSample< D >& s = samples[index.at( key ) * numTimes];
+                        if( !s.valid ) return;
+                        ++validCorners;
+                        auto f = probeFeatures( s );
+                        for( int m = 0; m < 3; ++m ) { fMin[m] = std::min( fMin[m], f[m] ); fMax[m] = std::max( fMax[m], f[m] ); }
+                    } );
+                    if( validCorners < 2 ) continue;
+                    double variation = 0.0;
+                    for( int m = 0; m < 3; ++m )
+                        if( range[m] > 0.0 ) variation = std::max( variation, ( fMax[m] - fMin[m] ) / range[m] );
+                    if( variation > refine.threshold ) scored.push_back( { variation, c } );
+                }
+                std::stable_sort( scored.begin(), scored.end(), []( const auto& a, const auto& b ) { return a.first > b.first; } );
 
-                        points.push_back( p );
-                        velocity.push_back( v );
-                        acceleration.push_back( a );
-                        gradient.push_back( J );
-                        divergence.push_back( computeDivergence( J ) );
-                        curvature.push_back( computeCurvature( v, a ) );
+                // Subdivide strongest first; each refined cell gets the corners of its children.
+                std::vector< Cell > children;
+                for( const auto& entry : scored )
+                {
+                    const Cell& cell = cells[entry.second];
+                    const long long half = cell.size / 2;
+                    std::vector< Key > fresh;
+                    forEachOffset( 3, half, [&]( const Key& o ) {
+                        Key key = { { cell.origin[0] + o[0], cell.origin[1] + o[1], cell.origin[2] + o[2] } };
+                        if( !index.count( key ) ) fresh.push_back( key );
+                    } );
+                    if( refine.maxProbes && positions.size() + fresh.size() > refine.maxProbes ) { budgetLeft = false; break; }
+                    for( const Key& key : fresh )
+                    {
+                        index[key] = positions.size();
+                        positions.push_back( position( key ) );
                     }
+                    forEachOffset( 2, half, [&]( const Key& o ) {
+                        children.push_back( { Key{ { cell.origin[0] + o[0], cell.origin[1] + o[1], cell.origin[2] + o[2] } }, half } );
+                    } );
+                }
+
+                debugLog() << "Refinement level " << level << ": " << scored.size() << " cell(s) above threshold, "
+                           << positions.size() * numTimes - samples.size() << " new sample(s)." << std::endl;
+                if( !sampleProbes( positions, samples, setup, evaluators, abortFlag, "Refining Probes" ) ) return false;
+                cells = std::move( children );
+            }
+
+            debugLog() << "Adaptive placement: " << coarse << " coarse + " << positions.size() - coarse << " refined probes." << std::endl;
+            return true;
+        }
+
+        // Publishes the valid probes in input order. samples holds one entry per slot (time step or ensemble member) and
+        // position; the plain outputs hold slot 0 and, with more than one slot, bundleName holds every slot.
+        // Quantities that were not computed get no Function and empty record arrays. Returns the probe point set (null if no probe is valid).
+        template< size_t D >
+        std::shared_ptr< const PointSet< 3 > > publishProbes( const std::vector< Point3 >& positions, const std::vector< ProbeSample< D > >& samples,
+                                                              const std::vector< std::string >& slots, const std::string& bundleName,
+                                                              const ProbeQuantities& quantities )
+        {
+            const size_t numSlots = slots.size();
+
+            // Compact valid probes (same order as a serial run); validity is shared by all slots of a position.
+            std::vector< size_t > valid;
+            std::vector< Point3 > points;
+            for( size_t idx = 0; idx < positions.size(); ++idx )
+            {
+                if( !samples[idx * numSlots].valid ) continue;
+                valid.push_back( idx );
+                points.push_back( positions[idx] );
+            }
 
             debugLog() << "Generated " << points.size() << " valid probes." << std::endl;
 
+            // Drop outputs of the previous run (e.g. "Gradient" after switching to planar data).
+            clearResults();
             // If no valid probes (e.g. field is zero everywhere), stop.
             if( points.empty() ) {
                 debugLog() << "Warning: No probes generated (field might be zero)." << std::endl;
-                clearResults(); return; 
+                return nullptr;
             }
 
             // Pack everything into a point set and attached functions so the renderer can use them.
+            std::vector< Point3 > recordPositions = points;
             auto pointSet = DomainFactory::makePointSet< 3 >( std::move( points ) );
             setResult( "Probe Points", pointSet );
-            setResult( "Velocity", fantom::addData( pointSet, PointSet< 3 >::Points, velocity ) );
-            setResult( "Acceleration", fantom::addData( pointSet, PointSet< 3 >::Points, acceleration ) );
-            setResult( "Gradient", fantom::addData( pointSet, PointSet< 3 >::Points, gradient ) );
-            setResult( "Divergence", fantom::addData( pointSet, PointSet< 3 >::Points, divergence ) );
-            setResult( "Curvature", fantom::addData( pointSet, PointSet< 3 >::Points, curvature ) );
 
-            debugLog() << "Finished LocalizedFlowProbe Calculation." << std::endl;
+            auto series = std::make_shared< DataObjectBundle >();
+            for( size_t t = 0; t < numSlots; ++t )
+            {
+                std::vector< Vector3 > velocity;
+                std::vector< Vector3 > acceleration;
+                std::vector< Tensor< double, D, D > > gradient;
+                std::vector< double > divergence;
+                std::vector< Vector3 > curvature;
+                velocity.reserve( valid.size() );
+                if( quantities.acceleration ) acceleration.reserve( valid.size() );
+                if( quantities.gradient ) gradient.reserve( valid.size() );
+                if( quantities.divergence ) divergence.reserve( valid.size() );
+                if( quantities.curvature ) curvature.reserve( valid.size() );
+                for( size_t idx : valid )
+                {
+                    const ProbeSample< D >& s = samples[idx * numSlots + t];
+                    velocity.push_back( s.velocity );
+                    if( quantities.acceleration ) acceleration.push_back( s.acceleration );
+                    if( quantities.gradient ) gradient.push_back( s.gradient );
+                    if( quantities.divergence ) divergence.push_back( s.divergence );
+                    if( quantities.curvature ) curvature.push_back( s.curvature );
+                }
+
+                std::vector< std::pair< std::string, std::shared_ptr< const DataObject > > > functions;
+                functions.emplace_back( "Velocity", fantom::addData( pointSet, PointSet< 3 >::Points, velocity ) );
+                if( quantities.acceleration ) functions.emplace_back( "Acceleration", fantom::addData( pointSet, PointSet< 3 >::Points, acceleration ) );
+                // "Gradient" is always 3x3 so sessions wired to it keep working on planar data; 2D runs add the raw 2x2 values.
+                std::vector< Tensor< double, 3, 3 > > gradient3;
+                gradient3.reserve( gradient.size() );
+                for( const auto& J : gradient ) gradient3.push_back( liftGradient( J ) );
+                if( quantities.gradient )
+                {
+                    functions.emplace_back( "Gradient", fantom::addData( pointSet, PointSet< 3 >::Points, gradient3 ) );
+                    if( D == 2 ) functions.emplace_back( "Gradient 2D", fantom::addData( pointSet, PointSet< 3 >::Points, gradient ) );
+                }
+                if( quantities.divergence ) functions.emplace_back( "Divergence", fantom::addData( pointSet, PointSet< 3 >::Points, divergence ) );
+                if( quantities.curvature ) functions.emplace_back( "Curvature", fantom::addData( pointSet, PointSet< 3 >::Points, curvature ) );
+
+                for( const auto& function : functions )
+                {
+                    if( t == 0 ) setResult( function.first, function.second );
+                    if( numSlots > 1 ) series->addContent( function.second, function.first + " [" + slots[t] + "]" );
+                }
+
+                // Slot 0 also goes out fused, so the renderer reads one object instead of five Functions.
+                if( t == 0 )
+                {
+                    setResult( "Probe Records", std::make_shared< const ProbeRecordSet >(
+                        std::move( recordPositions ), std::move( velocity ), std::move( acceleration ),
+                        std::move( gradient3 ), std::move( divergence ), std::move( curvature ) ) );
+                }
+            }
+            if( numSlots > 1 ) setResult( bundleName, series );
+            return pointSet;
         }
     };
 
@@ -251,10 +1642,12 @@ namespace aufgabe4_1
         {
             Options( fantom::Options::Control& control ) : VisAlgorithm::Options( control )
             {
-                add< PointSet< 3 > >( "Probe Points", "Sample points", Options::REQUIRED );
-                add< Function< Vector3 > >( "Velocity", "Velocity Field", Options::REQUIRED );
+                add< ProbeRecordSet >( "Probe Records", "Fused output of LocalizedFlowProbe (replaces the inputs below)" );
+                add< PointSet< 3 > >( "Probe Points", "Sample points (needed without Probe Records)" );
+                add< Function< Vector3 > >( "Velocity", "Velocity Field (needed without Probe Records)" );
                 add< Function< Vector3 > >( "Acceleration", "Acceleration Field (for Curvature)" );
                 add< Function< Tensor< double, 3, 3 > > >( "Gradient", "Gradient Field (Shear/Torsion)" );
+                add< Function< Tensor< double, 2, 2 > > >( "Gradient 2D", "Gradient of planar probes (used when no 3D gradient is connected)" );
                 add< Function< double > >( "Divergence", "Divergence (lens/color)" );
                 add< Function< Vector3 > >( "Curvature", "Curvature vector (optional; else from Velocity+Acceleration)" );
                 add< double >( "Glyph Scale", "Overall size (smaller = less overlap)", 0.5 );
@@ -265,6 +1658,9 @@ namespace aufgabe4_1
                 add< bool >( "Show Membrane", "Acceleration disc at tip", true );
                 add< bool >( "Show Lens", "Divergence paraboloid at base", true );
                 add< bool >( "Color by Probe ID", "One color per probe (arc/ring/head grouped); off = by divergence", true );
+                add< bool >( "Level of Detail", "Coarser glyphs where they are small relative to the scene", false );
+                add< int >( "Max Triangles", "Triangle budget; detail is reduced, smallest glyphs first, to fit (0 = no limit)", 0 );
+                add< int >( "Threads", "Worker threads for glyph generation (0 = all cores, 1 = serial)", 0 );
             }
         };
 
@@ -280,341 +1676,356 @@ namespace aufgabe4_1
 
         void execute( const Algorithm::Options& options, const volatile bool& abortFlag ) override
         {
-            // Read the data produced by the Localized Flow Probe algorithm (points + velocity, etc.).
+            // Inputs and options that shape the glyphs. The renderer keeps its instances and per-layer buffers between
+            // executions and only redoes what one of these invalidates.
+            const std::array< std::shared_ptr< const DataObject >, 8 > inputs = { { options.get< ProbeRecordSet >( "Probe Records" ), options.get< PointSet< 3 > >( "Probe Points" ),
+                             options.get< Function< Vector3 > >( "Velocity" ), options.get< Function< Vector3 > >( "Acceleration" ),
+                             options.get< Function< Tensor< double, 3, 3 > > >( "Gradient" ),
+                             options.get< Function< Tensor< double, 2, 2 > > >( "Gradient 2D" ),
+                             options.get< Function< double > >( "Divergence" ), options.get< Function< Vector3 > >( "Curvature" ) } };
+            GeometryKey key;
+            key.scale = options.get< double >( "Glyph Scale" );
+            key.tubeLength = std::max( 0.05, std::min( 1.0, options.get< double >( "Tube Length" ) ) );
+            key.ringSize = options.get< double >( "Ring Size" );
+            key.levelOfDetail = options.get< bool >( "Level of Detail" );
+            key.maxTriangles = std::max( 0, options.get< int >( "Max Triangles" ) );
+
+            // User options: overall size, shaft length, ring size, line thickness, and which parts to show.
+            GlyphParams params;
+            params.scale = key.scale;
+            params.tubeLength = key.tubeLength;
+            params.ringRad = params.scale * key.ringSize;
+            params.memRad = params.scale * key.ringSize * 0.8;
+            const float lineWidth = static_cast< float >( std::max( 0.5, options.get< double >( "Line Width" ) ) );
+            params.showTube = options.get< bool >( "Show Tube" );
+            params.showMembrane = options.get< bool >( "Show Membrane" );
+            params.showLens = options.get< bool >( "Show Lens" );
+            params.colorByProbeId = options.get< bool >( "Color by Probe ID" );
+            const std::array< bool, NumGlyphLayers > shown = { { true, true, params.showTube, params.showMembrane, params.showLens } };
+            // Which parts are shown only matters for the geometry when the triangle budget is shared between them.
+            if( key.maxTriangles > 0 ) key.shown = shown;
+
+            const bool rebuild = !mHasInstances || !sameKey( inputs, key );
+            const bool recolor = !rebuild && params.colorByProbeId != mColorByProbeId;
+            const int threadOption = options.get< int >( "Threads" );
+            if( rebuild || recolor )
+            {
+                ProbeArrays probes;
+                if( !readProbes( options, probes ) ) { reset(); clearGraphics( "Flow Probes" ); return; }
+                if( rebuild )
+                {
+                    params.hasGradient = probes.hasGradient;
+                    if( !buildInstances( probes, params, inputs, key, shown, threadOption, abortFlag ) ) { reset(); return; }
+                }
+                else
+                {
+                    // Only the coloring changed: new instance colors, geometry stays.
+                    parallelFor( mInstances.size(), resolveThreadCount( threadOption, mInstances.size(), kGlyphChunkSize ),
+                                 kGlyphChunkSize, abortFlag,
+                        [&]( size_t, size_t begin, size_t end ) {
+                            for( size_t i = begin; i < end; ++i )
+                                mInstances[i].color = packColor( glyphColor( probes, mProbeIndex[i], params.colorByProbeId ) );
+                        },
+                        []( size_t ) {} );
+                    if( abortFlag ) { reset(); return; }
+                    for( LayerCache& layer : mLayers ) layer.colors.reset();
+                }
+                mColorByProbeId = params.colorByProbeId;
+            }
+
+            std::vector< std::shared_ptr< graphics::Drawable > > drawables;
+            for( int layer = 0; layer < NumGlyphLayers; ++layer )
+            {
+                if( !shown[layer] ) continue;
+                LayerCache& cache = mLayers[layer];
+                if( !cache.built )
+                {
+                    buildLayer( layer, params, threadOption, abortFlag );
+                    if( abortFlag ) return;
+                }
+                if( cache.firstVertex.empty() || cache.firstVertex.back() == 0 ) continue;
+                if( !cache.colors ) uploadColors( layer, params, threadOption, abortFlag );
+                if( abortFlag ) return;
+                if( !cache.drawable || ( isLineLayer( layer ) && cache.lineWidth != lineWidth ) )
+                    cache.drawable = makeLayerDrawable( layer, lineWidth );
+                drawables.push_back( cache.drawable );
+            }
+            if( drawables.empty() ) { clearGraphics( "Flow Probes" ); return; }
+            setGraphics( "Flow Probes", graphics::makeCompound( drawables ) );
+        }
+
+    private:
+        // Options the instances depend on (besides the input objects, see mInputs).
+        struct GeometryKey
+        {
+            double scale = 0.0;
+            double tubeLength = 0.0;
+            double ringSize = 0.0;
+            bool levelOfDetail = false;
+            int maxTriangles = 0;
+            std::array< bool, NumGlyphLayers > shown = {};
+        };
+
+        // One uploaded glyph layer. firstVertex (per glyph, plus the total) and shade are kept for recoloring;
+        // colors and drawable are dropped when the coloring or line width changes.
+        struct LayerCache
+        {
+            bool built = false;
+            std::vector< size_t > firstVertex;
+            std::vector< float > shade;
+            std::shared_ptr< graphics::VertexBuffer > vertices;
+            std::shared_ptr< graphics::VertexBuffer > normals;
+            std::shared_ptr< graphics::IndexBuffer > indices;
+            std::shared_ptr< const graphics::BoundingSphere > bounds;
+            std::shared_ptr< graphics::VertexBuffer > colors;
+            std::shared_ptr< graphics::Drawable > drawable;
+            float lineWidth = 0.0f;
+        };
+
+        bool sameKey( const std::array< std::shared_ptr< const DataObject >, 8 >& inputs, const GeometryKey& key ) const
+        {
+            for( size_t i = 0; i < inputs.size(); ++i )
+                if( mInputs[i].lock() != inputs[i] ) return false;
+            return mKey.scale == key.scale && mKey.tubeLength == key.tubeLength && mKey.ringSize == key.ringSize
+                   && mKey.levelOfDetail == key.levelOfDetail && mKey.maxTriangles == key.maxTriangles && mKey.shown == key.shown;
+        }
+
+        void reset()
+        {
+            mHasInstances = false;
+            mInstances.clear();
+            mProbeIndex.clear();
+            for( LayerCache& layer : mLayers ) layer = LayerCache();
+        }
+
+        // Read the data produced by the Localized Flow Probe algorithm: the fused records, else points + velocity, etc.
+        bool readProbes( const Algorithm::Options& options, ProbeArrays& probes ) const
+        {
+            if( auto records = options.get< ProbeRecordSet >( "Probe Records" ) )
+            {
+                const size_t count = records->size();
+                const Vector3 zero( 0.0, 0.0, 0.0 );
+                probes.records = records;
+                probes.count = count;
+                probes.positions = records->positions().data();
+                probes.velocity = records->velocity().data();
+                probes.acceleration = recordValues( records->acceleration(), count, probes.accelerationStore, zero );
+                probes.gradient = recordValues( records->gradient(), count, probes.gradientStore, Tensor< double, 3, 3 >( { 0,0,0, 0,0,0, 0,0,0 } ) );
+                probes.divergence = recordValues( records->divergence(), count, probes.divergenceStore, 0.0 );
+                probes.curvature = recordValues( records->curvature(), count, probes.curvatureStore, zero );
+                if( records->curvature().size() != count )
+                    for( size_t i = 0; i < count; ++i )
+                        probes.curvatureStore[i] = computeCurvature( probes.velocity[i], probes.acceleration[i] );
+                probes.hasGradient = records->gradient().size() == count;
+                return true;
+            }
+
             auto pointSet = options.get< PointSet< 3 > >( "Probe Points" );
             auto velFunc = options.get< Function< Vector3 > >( "Velocity" );
+            if( !pointSet || !velFunc ) return false;
             auto accFunc = options.get< Function< Vector3 > >( "Acceleration" );
             auto gradFunc = options.get< Function< Tensor< double, 3, 3 > > >( "Gradient" );
+            auto grad2Func = gradFunc ? nullptr : options.get< Function< Tensor< double, 2, 2 > > >( "Gradient 2D" );
             auto divFunc = options.get< Function< double > >( "Divergence" );
             auto curvFunc = options.get< Function< Vector3 > >( "Curvature" );
-            if( !pointSet || !velFunc ) { clearGraphics( "Flow Probes" ); return; }
 
-            // User options: overall size, shaft length, ring size, line thickness, and which parts to show.
-            double scale = options.get< double >( "Glyph Scale" );
-            double tubeLength = std::max( 0.05, std::min( 1.0, options.get< double >( "Tube Length" ) ) );
-            double ringRelSize = options.get< double >( "Ring Size" );
-            double lineWidthOpt = std::max( 0.5, options.get< double >( "Line Width" ) );
-            bool showTube = options.get< bool >( "Show Tube" );
-            bool showMembrane = options.get< bool >( "Show Membrane" );
-            bool showLens = options.get< bool >( "Show Lens" );
-            bool colorByProbeId = options.get< bool >( "Color by Probe ID" );
+            // One pass per attribute; missing values get the defaults (a = 0, J = 0, div = 0, c from v and a).
             const auto& points = pointSet->points();
-            size_t numPoints = points.size();
+            const size_t count = std::min( points.size(), velFunc->values().size() );
+            const Vector3 zero( 0.0, 0.0, 0.0 );
+            const Tensor< double, 3, 3 > zeroJ( { 0,0,0, 0,0,0, 0,0,0 } );
+            auto same = []( const auto& x ) { return x; };
+            probes.count = count;
+            probes.positionStore.reserve( count );
+            for( size_t i = 0; i < count; ++i ) probes.positionStore.push_back( points[i] );
+            probes.positions = probes.positionStore.data();
+            probes.velocity = copyValues( velFunc.get(), count, probes.velocityStore, zero, same );
+            probes.acceleration = copyValues( accFunc.get(), count, probes.accelerationStore, zero, same );
+            if( gradFunc ) probes.gradient = copyValues( gradFunc.get(), count, probes.gradientStore, zeroJ, same );
+            else probes.gradient = copyValues( grad2Func.get(), count, probes.gradientStore, zeroJ,
+                                               []( const Tensor< double, 2, 2 >& J ) { return liftGradient( J ); } );
+            probes.divergence = copyValues( divFunc.get(), count, probes.divergenceStore, 0.0, same );
+            probes.curvature = copyValues( curvFunc.get(), count, probes.curvatureStore, zero, same );
+            for( size_t i = curvFunc ? std::min( count, curvFunc->values().size() ) : 0; i < count; ++i )
+                probes.curvatureStore[i] = computeCurvature( probes.velocity[i], probes.acceleration[i] );
+            probes.hasGradient = gradFunc || grad2Func;
+            return true;
+        }
+
+        // Instances: one compact record per drawable probe, with its level of detail. All layers are built from these.
+        bool buildInstances( const ProbeArrays& probes, GlyphParams& params, const std::array< std::shared_ptr< const DataObject >, 8 >& inputs,
+                             const GeometryKey& key,
+                             const std::array< bool, NumGlyphLayers >& shown, int threadOption, const volatile bool& abortFlag )
+        {
+            reset();
+            const size_t numPoints = probes.count;
 
             // We need the maximum velocity to scale shaft length (faster flow = longer shaft).
             double maxVel = 0.0;
-            for( size_t i = 0; i < numPoints && i < velFunc->values().size(); ++i )
+            for( size_t i = 0; i < numPoints; ++i )
             {
-                double vLen = norm( velFunc->values()[i] );
+                double vLen = norm( probes.velocity[i] );
                 if( vLen > maxVel ) maxVel = vLen;
             }
-            if( maxVel < 1e-9 ) maxVel = 1.0;
-
-            // Number of segments for arc, tube cross-section, lens: more = smoother but heavier.
-            constexpr double kappaEps = 1e-6;
-            const int arcSegs = 16;
-            const int tubeCirc = 10;
-            const int paraboloidRings = 6;
-            const int paraboloidSegs = 12;
-
-            // We fill these with vertices and indices; lines for arc/head/ring, triangles for tube/membrane/lens.
-            std::vector< PointF< 3 > > lineVerts;
-            std::vector< Color > lineColors;
-            std::vector< unsigned int > lineIndices;
-            std::vector< PointF< 3 > > triVerts;
-            std::vector< VectorF< 3 > > triNormals;
-            std::vector< Color > triColors;
-            std::vector< unsigned int > triIndices;
+            params.maxVel = ( maxVel < 1e-9 ) ? 1.0 : maxVel;
 
+            const size_t numThreads = resolveThreadCount( threadOption, numPoints, kGlyphChunkSize );
+            std::vector< ProbeInstance > instances( numPoints );
+            std::vector< char > drawable( numPoints, 0 );
+            parallelFor( numPoints, numThreads, kGlyphChunkSize, abortFlag,
+                [&]( size_t, size_t begin, size_t end ) {
+                    for( size_t i = begin; i < end; ++i ) drawable[i] = makeProbeInstance( probes, i, params, instances[i] );
+                },
+                []( size_t ) {} );
+            if( abortFlag ) return false;
+            size_t numInstances = 0;
             for( size_t i = 0; i < numPoints; ++i )
-            {
-                if( abortFlag ) break;
-                Point3 p = points[i];
-                if( i >= velFunc->values().size() ) continue;
-                Vector3 v = velFunc->values()[i];
-                double vLen = norm( v );
-                if( vLen < kMinDirectionNorm ) continue;
-
-                // Shaft length in "time" units: scaled by speed so faster flow gets a longer arrow.
-                double dt = scale * tubeLength * ( vLen / maxVel );
-                Vector3 a( 0, 0, 0 );
-                if( accFunc && i < accFunc->values().size() ) a = accFunc->values()[i];
-                Tensor< double, 3, 3 > J( { 0,0,0, 0,0,0, 0,0,0 } );
-                if( gradFunc && i < gradFunc->values().size() ) J = gradFunc->values()[i];
-                double div = 0.0;
-                if( divFunc && i < divFunc->values().size() ) div = divFunc->values()[i];
-                Vector3 c = ( curvFunc && i < curvFunc->values().size() ) ? curvFunc->values()[i] : computeCurvature( v, a );
-
-                // Color: by divergence (red = spreading, blue = converging) or one color per probe.
-                double divSat = std::tanh( div * 5.0 );
-                Color divColor = ( divSat > 0 ) ? Color( 1.0f, 1.0f - (float)divSat, 1.0f - (float)divSat )
-                                                : Color( 1.0f + (float)divSat, 1.0f + (float)divSat, 1.0f );
-                Color lineColor = colorByProbeId ? probeColor( i ) : divColor;
-                Color baseColor = colorByProbeId ? lineColor : divColor;
-                // Curl along flow direction: drives the torsion stripe pattern on the tube.
-                Vector3 curlVec = computeRotation( J );
-                double torsionProxy = ( vLen > 1e-12 ) ? ( curlVec * v ) / vLen : 0.0;
-
-                // Shaft = arc of osculating circle (radius 1/kappa, length L); fallback to straight segment.
-                Vector3 T = normalized( v );
-                double kappa = norm( c );
-                double L = vLen * dt;
-                std::vector< Point3 > arcPoints;
-                if( kappa < kappaEps || L < 1e-12 )
-                {
-                    arcPoints.push_back( p );
-                    arcPoints.push_back( p + T * L );
-                }
-                else
+                if( drawable[i] )
                 {
-                    double R = 1.0 / kappa;
-                    Vector3 N = normalized( c );
-                    Point3 center = p + R * N;
-                    double thetaMax = L / R;
-                    for( int s = 0; s <= arcSegs; ++s )
-                    {
-                        double theta = ( s * thetaMax ) / arcSegs;
-                        arcPoints.push_back( center + R * ( -std::cos( theta ) * N + std::sin( theta ) * T ) );
-                    }
-                }
-                // Where the arrow ends and which way it points (for head and membrane).
-                Point3 tipPos = arcPoints.back();
-                Vector3 tipDir = ( arcPoints.size() >= 2 )
-                    ? normalized( arcPoints.back() - arcPoints[ arcPoints.size() - 2 ] ) : T;
-                double drawLen = L;
-
-                // Draw the arc (shaft) and the arrow head as line segments (each segment = two vertices).
-                for( size_t s = 0; s + 1 < arcPoints.size(); ++s )
-                {
-                    size_t idx = lineVerts.size();
-                    lineVerts.push_back( toPointF( arcPoints[s] ) );
-                    lineVerts.push_back( toPointF( arcPoints[s + 1] ) );
-                    lineColors.push_back( lineColor );
-                    lineColors.push_back( lineColor );
-                    lineIndices.push_back( (unsigned int)idx );
-                    lineIndices.push_back( (unsigned int)idx + 1 );
+                    instances[numInstances++] = instances[i];
+                    mProbeIndex.push_back( i );
                 }
+            instances.resize( numInstances );
 
-                // Arrow head: small cone from tip backward. We need two perpendicular directions in the plane of the cone base.
-                double headSize = std::max( drawLen * 0.25, scale * 0.05 );
-                double headRad = headSize * 0.5;
-                Vector3 up( 0, 0, 1 );
-                if( std::abs( tipDir[2] ) > 0.9 ) up = Vector3( 0, 1, 0 );
-                Vector3 right = normalized( cross( tipDir, up ) );
-                up = normalized( cross( right, tipDir ) );
-                Point3 base = tipPos - tipDir * headSize;
-                for( int k = 0; k < 8; ++k )
-                {
-                    double ang = k * M_PI / 4.0;
-                    Vector3 off = ( right * std::cos( ang ) + up * std::sin( ang ) ) * headRad;
-                    size_t hIdx = lineVerts.size();
-                    lineVerts.push_back( toPointF( tipPos ) );
-                    lineVerts.push_back( toPointF( base + off ) );
-                    lineColors.push_back( lineColor );
-                    lineColors.push_back( lineColor );
-                    lineIndices.push_back( (unsigned int)hIdx );
-                    lineIndices.push_back( (unsigned int)hIdx + 1 );
-                }
-
-                // Shear ring in plane perpendicular to flow; J deforms it (Frenet frame if curvature available).
-                double ringRad = scale * ringRelSize;
-                Vector3 dir = normalized( v );
-                Vector3 ringUp( 0, 0, 1 );
-                if( std::abs( dir[2] ) > 0.9 ) ringUp = Vector3( 0, 1, 0 );
-                Vector3 ringRight = normalized( cross( dir, ringUp ) );
-                ringUp = normalized( cross( ringRight, dir ) );
-                if( kappa >= kappaEps ) { ringRight = normalized( cross( dir, c ) ); ringUp = normalized( cross( ringRight, dir ) ); }
-                Point3 ringCenter = p;
-                Color ringColor = colorByProbeId ? lineColor : Color( 0.2f, 0.2f, 0.2f );
-                auto deform = [&]( const Point3& pt ) {
-                    Vector3 r = pt - ringCenter;
-                    return pt + J * r * ( dt * 0.5 );
-                };
-                // Draw the ring as 20 line segments; each segment connects two points on the (possibly deformed) circle.
-                int ringSegs = 20;
-                Point3 prevRingPt = ringCenter + ringRight * ringRad;
-                if( gradFunc ) prevRingPt = deform( prevRingPt );
-                for( int k = 1; k <= ringSegs; ++k )
-                {
-                    double ang = k * 2.0 * M_PI / ringSegs;
-                    Point3 currPt = ringCenter + ( ringRight * std::cos( ang ) + ringUp * std::sin( ang ) ) * ringRad;
-                    if( gradFunc ) currPt = deform( currPt );
-                    size_t rIdx = lineVerts.size();
-                    lineVerts.push_back( toPointF( prevRingPt ) );
-                    lineVerts.push_back( toPointF( currPt ) );
-                    lineColors.push_back( ringColor );
-                    lineColors.push_back( ringColor );
-                    lineIndices.push_back( (unsigned int)rIdx );
-                    lineIndices.push_back( (unsigned int)rIdx + 1 );
-                    prevRingPt = currPt;
-                }
-
-                // Tube along arc; stripe phase from torsion proxy (curl·u) for candy-stripe effect.
-                double tubeRad = std::max( drawLen * 0.04, scale * 0.02 );
-                size_t tubeBaseIdx = triVerts.size();
-                double arcLenSoFar = 0.0;
-                if( showTube )
-                {
-                // At each point along the arc we add a circle of vertices (tube cross-section). Tangent and two perpendiculars define the circle.
-                for( size_t s = 0; s < arcPoints.size(); ++s )
-                {
-                    Vector3 tangent = ( s + 1 < arcPoints.size() )
-                        ? normalized( arcPoints[s + 1] - arcPoints[s] )
-                        : ( s > 0 ? normalized( arcPoints[s] - arcPoints[s - 1] ) : T );
-                    Vector3 tu( 0, 0, 1 );
-                    if( std::abs( tangent[2] ) > 0.9 ) tu = Vector3( 0, 1, 0 );
-                    Vector3 tx = normalized( cross( tangent, tu ) );
-                    Vector3 ty = normalized( cross( tx, tangent ) );
-                    for( int k = 0; k <= tubeCirc; ++k )
-                    {
-                        double phi = k * 2.0 * M_PI / tubeCirc;
-                        Point3 pt = arcPoints[s] + ( tx * std::cos( phi ) + ty * std::sin( phi ) ) * tubeRad;
-                        triVerts.push_back( toPointF( pt ) );
-                        Vector3 n = normalized( tx * std::cos( phi ) + ty * std::sin( phi ) );
-                        triNormals.push_back( VectorF<3>( (float)n[0], (float)n[1], (float)n[2] ) );
-                        float stripe = 0.5f + 0.5f * std::cos( (float)( phi + torsionProxy * arcLenSoFar * 2.0 ) );
-                        triColors.push_back( Color( stripe * baseColor.r(), stripe * baseColor.g(), stripe * baseColor.b(), 1.0f ) );
-                    }
-                    if( s + 1 < arcPoints.size() ) arcLenSoFar += norm( arcPoints[s + 1] - arcPoints[s] );
-                }
-                // Connect the tube circles into quads, each quad as two triangles (indices).
-                for( size_t s = 0; s + 1 < arcPoints.size(); ++s )
-                {
-                    for( int k = 0; k < tubeCirc; ++k )
+            if( key.levelOfDetail && numInstances > 0 )
+            {
+                Point3 lo = toVector3( instances[0].position ), hi = lo;
+                for( const ProbeInstance& g : instances )
+                    for( int d = 0; d < 3; ++d )
                     {
-                        int k1 = ( k + 1 ) % ( tubeCirc + 1 );
-                        unsigned int i00 = (unsigned int)( tubeBaseIdx + s * ( tubeCirc + 1 ) + k );
-                        unsigned int i01 = (unsigned int)( tubeBaseIdx + s * ( tubeCirc + 1 ) + k1 );
-                        unsigned int i10 = (unsigned int)( tubeBaseIdx + ( s + 1 ) * ( tubeCirc + 1 ) + k );
-                        unsigned int i11 = (unsigned int)( tubeBaseIdx + ( s + 1 ) * ( tubeCirc + 1 ) + k1 );
-                        triIndices.push_back( i00 ); triIndices.push_back( i01 ); triIndices.push_back( i10 );
-                        triIndices.push_back( i01 ); triIndices.push_back( i11 ); triIndices.push_back( i10 );
+                        lo[d] = std::min( lo[d], (double)g.position[d] );
+                        hi[d] = std::max( hi[d], (double)g.position[d] );
                     }
-                }
-                }
+                const double extent = norm( hi - lo );
+                for( ProbeInstance& g : instances ) g.lod = glyphLevel( g, params, extent );
+            }
+            if( key.maxTriangles > 0 ) applyTriangleBudget( instances, mLevels, shown, static_cast< size_t >( key.maxTriangles ) );
 
-                // Acceleration disc at tip; bulge along flow from a·u.
-                double aAlongU = ( vLen > 1e-12 ) ? ( a * v ) / vLen : 0.0;
-                if( showMembrane )
-                {
-                // Membrane: disc at tip. Center is shifted along flow by acceleration (bulge); ring of points around it.
-                double memRad = scale * ringRelSize * 0.8;
-                int memSegs = 16;
-                size_t memBase = triVerts.size();
-                double bulge = 0.15 * scale * std::tanh( aAlongU * 2.0 );
-                triVerts.push_back( toPointF( tipPos + tipDir * bulge ) );
-                triNormals.push_back( VectorF<3>( (float)tipDir[0], (float)tipDir[1], (float)tipDir[2] ) );
-                triColors.push_back( baseColor );
-                for( int k = 0; k <= memSegs; ++k )
-                {
-                    double ang = k * 2.0 * M_PI / memSegs;
-                    Point3 pt = tipPos + ( right * std::cos( ang ) + up * std::sin( ang ) ) * memRad;
-                    triVerts.push_back( toPointF( pt ) );
-                    Vector3 n = normalized( -tipDir );
-                    triNormals.push_back( VectorF<3>( (float)n[0], (float)n[1], (float)n[2] ) );
-                    triColors.push_back( baseColor );
-                }
-                // Triangle fan: center to each consecutive pair of ring points.
-                for( int k = 0; k < memSegs; ++k )
-                {
-                    triIndices.push_back( (unsigned int)memBase );
-                    triIndices.push_back( (unsigned int)( memBase + k + 1 ) );
-                    triIndices.push_back( (unsigned int)( memBase + ( k + 2 <= memSegs + 1 ? k + 2 : 1 ) ) );
-                }
-                }
+            mInstances = std::move( instances );
+            for( size_t i = 0; i < inputs.size(); ++i ) mInputs[i] = inputs[i];
+            mKey = key;
+            mHasInstances = true;
+            return true;
+        }
 
-                // Lens (paraboloid) at probe base: center vertex plus rings; height follows divergence (dome or bowl).
-                if( showLens )
-                {
-                double lensRad = scale * ringRelSize;
-                double kDiv = 0.08 * scale * std::tanh( div * 3.0 );
-                size_t lensBase = triVerts.size();
-                triVerts.push_back( toPointF( p ) );
-                triNormals.push_back( VectorF<3>( (float)dir[0], (float)dir[1], (float)dir[2] ) );
-                triColors.push_back( baseColor );
-                for( int r = 1; r <= paraboloidRings; ++r )
-                {
-                    double rad = ( r * lensRad ) / paraboloidRings;
-                    double z = kDiv * ( rad * rad ) / ( lensRad * lensRad + 1e-12 );
-                    for( int seg = 0; seg < paraboloidSegs; ++seg )
-                    {
-                        double ang = seg * 2.0 * M_PI / paraboloidSegs;
-                        Point3 pt = p + ( ringRight * std::cos( ang ) + ringUp * std::sin( ang ) ) * rad + dir * z;
-                        triVerts.push_back( toPointF( pt ) );
-                        double dzdr = ( lensRad > 1e-12 && rad > 1e-12 ) ? ( 2.0 * kDiv * rad / ( lensRad * lensRad ) ) : 0.0;
-                        Vector3 radial = normalized( ringRight * std::cos( ang ) + ringUp * std::sin( ang ) );
-                        Vector3 n = ( rad > 1e-12 ) ? normalized( radial - dir * dzdr ) : dir;
-                        triNormals.push_back( VectorF<3>( (float)n[0], (float)n[1], (float)n[2] ) );
-                        triColors.push_back( baseColor );
-                    }
-                }
-                // Triangles from center to first ring.
-                for( int seg = 0; seg < paraboloidSegs; ++seg )
-                {
-                    int seg1 = ( seg + 1 ) % paraboloidSegs;
-                    triIndices.push_back( (unsigned int)lensBase );
-                    triIndices.push_back( (unsigned int)( lensBase + 1 + seg ) );
-                    triIndices.push_back( (unsigned int)( lensBase + 1 + seg1 ) );
-                }
-                // Triangles between consecutive rings.
-                for( int r = 0; r < paraboloidRings - 1; ++r )
-                {
-                    for( int seg = 0; seg < paraboloidSegs; ++seg )
-                    {
-                        int seg1 = ( seg + 1 ) % paraboloidSegs;
-                        unsigned int a0 = (unsigned int)( lensBase + 1 + r * paraboloidSegs + seg );
-                        unsigned int a1 = (unsigned int)( lensBase + 1 + r * paraboloidSegs + seg1 );
-                        unsigned int b0 = (unsigned int)( lensBase + 1 + ( r + 1 ) * paraboloidSegs + seg );
-                        unsigned int b1 = (unsigned int)( lensBase + 1 + ( r + 1 ) * paraboloidSegs + seg1 );
-                        triIndices.push_back( a0 ); triIndices.push_back( a1 ); triIndices.push_back( b0 );
-                        triIndices.push_back( a1 ); triIndices.push_back( b1 ); triIndices.push_back( b0 );
-                    }
-                }
-                }
+        // Counting pass and prefix sum give every glyph its own ranges, so the fill runs on all threads and produces exactly
+        // the buffers of a serial expansion. The graphics API has no instanced drawing, so every glyph is expanded to full
+        // per-vertex geometry here and the uploaded buffers are as large as without instances.
+        void buildLayer( int layer, const GlyphParams& params, int threadOption, const volatile bool& abortFlag )
+        {
+            LayerCache& cache = mLayers[layer];
+            cache = LayerCache();
+            const size_t numInstances = mInstances.size();
+            std::vector< LayerOffsets > offsets( numInstances );
+            LayerOffsets total;
+            cache.firstVertex.resize( numInstances + 1 );
+            for( size_t i = 0; i < numInstances; ++i )
+            {
+                offsets[i] = total;
+                cache.firstVertex[i] = total.vert;
+                LayerOffsets n = layerCounts( layer, mInstances[i], mLevels[mInstances[i].lod] );
+                total.vert += n.vert;
+                total.index += n.index;
             }
+            cache.firstVertex[numInstances] = total.vert;
+
+            LayerMesh mesh;
+            mesh.verts.resize( total.vert );
+            if( !isLineLayer( layer ) ) mesh.normals.resize( total.vert );
+            if( layer == TubeLayer ) mesh.shade.resize( total.vert );
+            mesh.indices.resize( total.index );
+
+            const size_t numThreads = resolveThreadCount( threadOption, numInstances, kGlyphChunkSize );
+            std::vector< GlyphShaft > scratch( numThreads );
+            parallelFor( numInstances, numThreads, kGlyphChunkSize, abortFlag,
+                [&]( size_t thread, size_t begin, size_t end ) {
+                    for( size_t i = begin; i < end; ++i )
+                        expandLayer( layer, mInstances[i], mLevels[mInstances[i].lod], params, mesh, offsets[i], scratch[thread] );
+                },
+                []( size_t ) {} );
+            if( abortFlag ) { cache = LayerCache(); return; }
 
-            // One drawable for lines (arc, head, ring), one for triangles (tube, membrane, lens); compound to single output.
+            cache.built = true;
+            if( total.vert == 0 ) return;
             auto const& system = graphics::GraphicsSystem::instance();
-            std::string resourcePath = PluginRegistrationService::getInstance().getResourcePath( "utils/Graphics" );
-            if( !resourcePath.empty() && resourcePath.back() != '/' ) resourcePath += "/";
+            cache.vertices = system.makeBuffer( mesh.verts );
+            if( !mesh.normals.empty() ) cache.normals = system.makeBuffer( mesh.normals );
+            cache.indices = system.makeIndexBuffer( mesh.indices );
+            cache.bounds = std::make_shared< const graphics::BoundingSphere >( graphics::computeBoundingSphere( mesh.verts ) );
+            cache.shade = std::move( mesh.shade );
+        }
 
-            std::vector< std::shared_ptr< graphics::Drawable > > drawables;
-            // Lines (arc, head, ring): load line shader, create one drawable with vertex/color/index buffers.
-            if( !lineVerts.empty() )
+        void uploadColors( int layer, const GlyphParams& params, int threadOption, const volatile bool& abortFlag )
+        {
+            LayerCache& cache = mLayers[layer];
+            std::vector< Color > colors( cache.firstVertex.back() );
+            const size_t numInstances = mInstances.size();
+            parallelFor( numInstances, resolveThreadCount( threadOption, numInstances, kGlyphChunkSize ), kGlyphChunkSize, abortFlag,
+                [&]( size_t, size_t begin, size_t end ) {
+                    layerColors( layer, mInstances, cache.firstVertex, cache.shade, params, begin, end, colors );
+                },
+                []( size_t ) {} );
+            if( abortFlag ) return;
+            cache.colors = graphics::GraphicsSystem::instance().makeBuffer( colors );
+            cache.drawable.reset();
+        }
+
+        // Lines (arc, head, ring) with the line shader, surfaces (tube, membrane, lens) with Phong; the programs are
+        // compiled once per renderer.
+        std::shared_ptr< graphics::Drawable > makeLayerDrawable( int layer, float lineWidth )
+        {
+            LayerCache& cache = mLayers[layer];
+            auto const& system = graphics::GraphicsSystem::instance();
+            if( !mLineProgram )
             {
-                auto lineProg = system.makeProgramFromFiles(
+                std::string resourcePath = PluginRegistrationService::getInstance().getResourcePath( "utils/Graphics" );
+                if( !resourcePath.empty() && resourcePath.back() != '/' ) resourcePath += "/";
+                mLineProgram = system.makeProgramFromFiles(
                     resourcePath + "shader/line/noShading/multiColor/vertex.glsl",
                     resourcePath + "shader/line/noShading/multiColor/fragment.glsl",
                     resourcePath + "shader/line/noShading/multiColor/geometry.glsl" );
-                auto lineDraw = system.makePrimitive(
-                    graphics::PrimitiveConfig{ graphics::RenderPrimitives::LINES }
-                        .vertexBuffer( "in_vertex", system.makeBuffer( lineVerts ) )
-                        .vertexBuffer( "in_color", system.makeBuffer( lineColors ) )
-                        .indexBuffer( system.makeIndexBuffer( lineIndices ) )
-                        .boundingSphere( graphics::computeBoundingSphere( lineVerts ) )
-                        .uniform( "u_lineWidth", static_cast< float >( lineWidthOpt ) ),
-                    lineProg );
-                drawables.push_back( lineDraw );
-            }
-            // Triangles (tube, membrane, lens): Phong shader with normals and colors; one drawable.
-            if( !triVerts.empty() )
-            {
-                auto triProg = system.makeProgramFromFiles(
+                mTriProgram = system.makeProgramFromFiles(
                     resourcePath + "shader/surface/phong/multiColor/vertex.glsl",
                     resourcePath + "shader/surface/phong/multiColor/fragment.glsl" );
-                auto triDraw = system.makePrimitive(
-                    graphics::PrimitiveConfig{ graphics::RenderPrimitives::TRIANGLES }
-                        .vertexBuffer( "position", system.makeBuffer( triVerts ) )
-                        .vertexBuffer( "normal", system.makeBuffer( triNormals ) )
-                        .vertexBuffer( "color", system.makeBuffer( triColors ) )
-                        .indexBuffer( system.makeIndexBuffer( triIndices ) )
-                        .boundingSphere( graphics::computeBoundingSphere( triVerts ) ),
-                    triProg );
-                drawables.push_back( triDraw );
             }
-            if( drawables.empty() ) { clearGraphics( "Flow Probes" ); return; }
-            setGraphics( "Flow Probes", graphics::makeCompound( drawables ) );
+
+            cache.lineWidth = lineWidth;
+            if( isLineLayer( layer ) )
+                return system.makePrimitive(
+                    graphics::PrimitiveConfig{ graphics::RenderPrimitives::LINES }
+                        .vertexBuffer( "in_vertex", cache.vertices )
+                        .vertexBuffer( "in_color", cache.colors )
+                        .indexBuffer( cache.indices )
+                        .boundingSphere( *cache.bounds )
+                        .uniform( "u_lineWidth", lineWidth ),
+                    mLineProgram );
+            return system.makePrimitive(
+                graphics::PrimitiveConfig{ graphics::RenderPrimitives::TRIANGLES }
+                    .vertexBuffer( "position", cache.vertices )
+                    .vertexBuffer( "normal", cache.normals )
+                    .vertexBuffer( "color", cache.colors )
+                    .indexBuffer( cache.indices )
+                    .boundingSphere( *cache.bounds ),
+                mTriProgram );
         }
+
+        // Tessellation per level of detail (arc, tube cross-section, ring, membrane, lens rings and segments, head spokes):
+        // full, medium, coarse, and shaft line plus ring.
+        const std::vector< GlyphTemplate > mLevels = {
+            makeGlyphTemplate( 16, 10, 20, 16, 6, 12, 8, true ),
+            makeGlyphTemplate( 8, 6, 12, 10, 3, 8, 6, true ),
+            makeGlyphTemplate( 4, 4, 8, 6, 2, 6, 4, true ),
+            makeGlyphTemplate( 4, 4, 8, 6, 2, 6, 0, false ) };
+
+        bool mHasInstances = false;
+        std::array< std::weak_ptr< const DataObject >, 8 > mInputs; // weak, so a new input is never mistaken for a freed one at the same address
+        GeometryKey mKey;
+        bool mColorByProbeId = false;
+        std::vector< ProbeInstance > mInstances;
+        std::vector< size_t > mProbeIndex; // probe of each instance (for recoloring)
+        std::array< LayerCache, NumGlyphLayers > mLayers;
+        std::shared_ptr< graphics::ShaderProgram > mLineProgram;
+        std::shared_ptr< graphics::ShaderProgram > mTriProgram;
     };
 
     AlgorithmRegister< FlowProbeRenderer > registerFlowRenderer(
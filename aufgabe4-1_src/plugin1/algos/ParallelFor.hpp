@@ -0,0 +1,72 @@
+// Small thread-pool helper shared by the Aufgabe 4.1 algorithms (std::thread only, no FAnToM dependency).
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace aufgabe4_1
+{
+    // Worker count for a "Threads" option (0 = all hardware threads), clamped so every worker gets at least one chunk.
+    inline size_t resolveThreadCount( int requested, size_t count, size_t chunkSize )
+    {
+        size_t threads = ( requested > 0 ) ? static_cast< size_t >( requested )
+                                           : std::max( 1u, std::thread::hardware_concurrency() );
+        size_t chunks = ( count + chunkSize - 1 ) / std::max< size_t >( 1, chunkSize );
+        return std::max< size_t >( 1, std::min( threads, chunks ) );
+    }
+
+    // Runs body( thread, begin, end ) over [0, count) in chunks of chunkSize on numThreads threads.
+    // Chunks are handed out dynamically, so the body must write its results by index (never append) to stay deterministic.
+    // The calling thread works as thread 0 and is the only one calling onProgress( itemsDone ), so Algorithm::Progress is
+    // never touched concurrently. No new chunks start once abortFlag is set; the first exception of any worker is rethrown here.
+    template< typename Body, typename OnProgress >
+    void parallelFor( size_t count, size_t numThreads, size_t chunkSize, const volatile bool& abortFlag, Body&& body, OnProgress&& onProgress )
+    {
+        chunkSize = std::max< size_t >( 1, chunkSize );
+        const size_t numChunks = ( count + chunkSize - 1 ) / chunkSize;
+        numThreads = std::max< size_t >( 1, std::min( numThreads, numChunks ) );
+
+        std::atomic< size_t > nextChunk( 0 );
+        std::atomic< size_t > itemsDone( 0 );
+        std::atomic< bool > failed( false );
+        std::exception_ptr error;
+        std::mutex errorMutex;
+
+        auto work = [&]( size_t thread ) {
+            try
+            {
+                for( ;; )
+                {
+                    if( abortFlag || failed ) return;
+                    size_t chunk = nextChunk.fetch_add( 1 );
+                    if( chunk >= numChunks ) return;
+                    size_t begin = chunk * chunkSize;
+                    size_t end = std::min( count, begin + chunkSize );
+                    body( thread, begin, end );
+                    size_t done = itemsDone.fetch_add( end - begin ) + ( end - begin );
+                    if( thread == 0 ) onProgress( done );
+                }
+            }
+            catch( ... )
+            {
+                std::lock_guard< std::mutex > lock( errorMutex );
+                if( !error ) error = std::current_exception();
+                failed = true;
+            }
+        };
+
+        std::vector< std::thread > workers;
+        workers.reserve( numThreads - 1 );
+        for( size_t t = 1; t < numThreads; ++t ) workers.emplace_back( work, t );
+        work( 0 );
+        for( auto& w : workers ) w.join();
+
+        if( error ) std::rethrow_exception( error );
+    }
+} // namespace aufgabe4_1
@@ -0,0 +1,47 @@
+// Fused per-probe output of LocalizedFlowProbe, consumed directly by FlowProbeRenderer.
+
+#pragma once
+
+#include <cstddef>
+#include <fantom/datastructures/DataObject.hpp>
+#include <fantom/math.hpp>
+#include <utility>
+#include <vector>
+
+namespace aufgabe4_1
+{
+    // All attributes of the probes in structure-of-arrays form, one entry per probe in the order of "Probe Points".
+    // Attributes that were not computed are empty. Planar gradients are stored lifted to 3x3.
+    // Immutable once built, so consumers can keep pointers into the arrays.
+    class ProbeRecordSet : public fantom::DataObject
+    {
+    public:
+        ProbeRecordSet( std::vector< fantom::Point3 > positions, std::vector< fantom::Vector3 > velocity,
+                        std::vector< fantom::Vector3 > acceleration, std::vector< fantom::Tensor< double, 3, 3 > > gradient,
+                        std::vector< double > divergence, std::vector< fantom::Vector3 > curvature )
+            : mPositions( std::move( positions ) )
+            , mVelocity( std::move( velocity ) )
+            , mAcceleration( std::move( acceleration ) )
+            , mGradient( std::move( gradient ) )
+            , mDivergence( std::move( divergence ) )
+            , mCurvature( std::move( curvature ) )
+        {
+        }
+
+        size_t size() const { return mPositions.size(); }
+        const std::vector< fantom::Point3 >& positions() const { return mPositions; }
+        const std::vector< fantom::Vector3 >& velocity() const { return mVelocity; }
+        const std::vector< fantom::Vector3 >& acceleration() const { return mAcceleration; }
+        const std::vector< fantom::Tensor< double, 3, 3 > >& gradient() const { return mGradient; }
+        const std::vector< double >& divergence() const { return mDivergence; }
+        const std::vector< fantom::Vector3 >& curvature() const { return mCurvature; }
+
+    private:
+        std::vector< fantom::Point3 > mPositions;
+        std::vector< fantom::Vector3 > mVelocity;
+        std::vector< fantom::Vector3 > mAcceleration;
+        std::vector< fantom::Tensor< double, 3, 3 > > mGradient;
+        std::vector< double > mDivergence;
+        std::vector< fantom::Vector3 > mCurvature;
+    };
+} // namespace aufgabe4_1
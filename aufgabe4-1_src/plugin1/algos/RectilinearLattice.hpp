@@ -0,0 +1,148 @@
+// Axis-aligned point lattice recovered from a grid's point list, with cell location and the trilinear cell basis.
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <fantom/math.hpp>
+#include <vector>
+
+namespace aufgabe4_1
+{
+    // Containing cell of a point: lower corner index per axis and local coordinates in [0,1].
+    struct LatticeCell
+    {
+        std::array< size_t, 3 > base;
+        std::array< double, 3 > local;
+    };
+
+    // Rectilinear lattice (VTK point order, x fastest). Axes of size 1 are degenerate (planar data);
+    // derivatives along them are zero.
+    class RectilinearLattice
+    {
+    public:
+        // Detects the lattice; false if the points are not a full tensor product of three increasing axes.
+        template< typename Points >
+        bool build( const Points& points )
+        {
+            for( auto& ax : mAxes ) ax.clear();
+            const size_t n = points.size();
+            if( n == 0 ) return false;
+
+            const fantom::Point3 first = points[0];
+            size_t nx = 1;
+            while( nx < n && points[nx][1] == first[1] && points[nx][2] == first[2] ) ++nx;
+            size_t ny = 1;
+            while( ny * nx < n && points[ny * nx][2] == first[2] ) ++ny;
+            if( n % ( nx * ny ) != 0 ) return false;
+            size_t nz = n / ( nx * ny );
+
+            for( size_t i = 0; i < nx; ++i ) mAxes[0].push_back( points[i][0] );
+            for( size_t j = 0; j < ny; ++j ) mAxes[1].push_back( points[j * nx][1] );
+            for( size_t k = 0; k < nz; ++k ) mAxes[2].push_back( points[k * nx * ny][2] );
+            for( auto& ax : mAxes )
+                for( size_t i = 1; i < ax.size(); ++i )
+                    if( !( ax[i] > ax[i - 1] ) ) { clear(); return false; }
+
+            // Every point must sit exactly where the axes say it does.
+            for( size_t k = 0; k < nz; ++k )
+                for( size_t j = 0; j < ny; ++j )
+                    for( size_t i = 0; i < nx; ++i )
+                    {
+                        const fantom::Point3 p = points[pointIndex( i, j, k )];
+                        if( p[0] != mAxes[0][i] || p[1] != mAxes[1][j] || p[2] != mAxes[2][k] ) { clear(); return false; }
+                    }
+
+            for( int d = 0; d < 3; ++d ) mTolerance[d] = 1e-9 * std::max( 1.0, mAxes[d].back() - mAxes[d].front() );
+            return true;
+        }
+
+        bool valid() const { return !mAxes[0].empty(); }
+        void clear() { for( auto& ax : mAxes ) ax.clear(); }
+        size_t size( int axis ) const { return mAxes[axis].size(); }
+        const std::vector< double >& axis( int axis ) const { return mAxes[axis]; }
+
+        size_t pointIndex( size_t i, size_t j, size_t k ) const
+        {
+            return i + mAxes[0].size() * ( j + mAxes[1].size() * k );
+        }
+
+        // Binary search per axis; false if p lies outside the lattice.
+        bool locate( const fantom::Point3& p, LatticeCell& cell ) const
+        {
+            for( int d = 0; d < 3; ++d )
+            {
+                const auto& ax = mAxes[d];
+                if( p[d] < ax.front() - mTolerance[d] || p[d] > ax.back() + mTolerance[d] ) return false;
+                if( ax.size() == 1 ) { cell.base[d] = 0; cell.local[d] = 0.0; continue; }
+                size_t upper = std::upper_bound( ax.begin(), ax.end(), p[d] ) - ax.begin();
+                size_t c = std::min( std::max< size_t >( upper, 1 ), ax.size() - 1 ) - 1;
+                cell.base[d] = c;
+                cell.local[d] = std::max( 0.0, std::min( 1.0, ( p[d] - ax[c] ) / ( ax[c + 1] - ax[c] ) ) );
+            }
+            return true;
+        }
+
+        // Multilinear interpolation of point data in this cell (degenerate axes only read their single layer).
+        template< typename Values >
+        fantom::Vector3 interpolate( const LatticeCell& cell, const Values& values ) const
+        {
+            fantom::Vector3 v( 0.0, 0.0, 0.0 );
+            for( size_t corner = 0; corner < 8; ++corner )
+            {
+                std::array< size_t, 3 > o = { { corner & 1, ( corner >> 1 ) & 1, ( corner >> 2 ) & 1 } };
+                double w = 1.0;
+                for( int d = 0; d < 3 && w != 0.0; ++d )
+                {
+                    if( o[d] && mAxes[d].size() == 1 ) w = 0.0;
+                    else w *= o[d] ? cell.local[d] : 1.0 - cell.local[d];
+                }
+                if( w == 0.0 ) continue;
+                v += w * fantom::Vector3( values[pointIndex( cell.base[0] + o[0], cell.base[1] + o[1], cell.base[2] + o[2] )] );
+            }
+            return v;
+        }
+
+        // Exact derivative of the multilinear interpolant of point data in this cell: J(r, c) = dv_r / dx_c.
+        // D = 2 restricts J to x/y (planar data, only the four corners of the z = 0 layer are read).
+        template< size_t D, typename Values >
+        fantom::Tensor< double, D, D > jacobian( const LatticeCell& cell, const Values& values ) const
+        {
+            fantom::Tensor< double, D, D > J;
+            for( size_t r = 0; r < D; ++r )
+                for( size_t c = 0; c < D; ++c ) J( r, c ) = 0.0;
+
+            std::array< double, 3 > width = { { 0.0, 0.0, 0.0 } };
+            for( size_t d = 0; d < D; ++d )
+                if( mAxes[d].size() > 1 ) width[d] = mAxes[d][cell.base[d] + 1] - mAxes[d][cell.base[d]];
+
+            for( size_t corner = 0; corner < ( size_t( 1 ) << D ); ++corner )
+            {
+                std::array< size_t, 3 > o = { { corner & 1, ( corner >> 1 ) & 1, ( corner >> 2 ) & 1 } };
+                bool skip = false;
+                std::array< double, 3 > w = { { 1.0, 1.0, 1.0 } }, dw = { { 0.0, 0.0, 0.0 } };
+                for( size_t d = 0; d < D; ++d )
+                {
+                    if( o[d] && width[d] == 0.0 ) { skip = true; break; }
+                    const double t = cell.local[d];
+                    w[d] = o[d] ? t : 1.0 - t;
+                    dw[d] = ( width[d] == 0.0 ) ? 0.0 : ( o[d] ? 1.0 : -1.0 ) / width[d];
+                }
+                if( skip ) continue;
+
+                const fantom::Vector3 v = values[pointIndex( cell.base[0] + o[0], cell.base[1] + o[1], cell.base[2] + o[2] )];
+                const double dBasis[3] = { dw[0] * w[1] * w[2], w[0] * dw[1] * w[2], w[0] * w[1] * dw[2] };
+                for( size_t r = 0; r < D; ++r )
+                    for( size_t c = 0; c < D; ++c )
+                        J( r, c ) += v[r] * dBasis[c];
+            }
+            return J;
+        }
+
+    private:
+        std::array< std::vector< double >, 3 > mAxes;
+        std::array< double, 3 > mTolerance = { { 0.0, 0.0, 0.0 } };
+    };
+} // namespace aufgabe4_1
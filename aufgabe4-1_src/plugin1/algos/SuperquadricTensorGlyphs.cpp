@@ -1,21 +1,37 @@
 // Superquadric tensor glyphs (Kindlmann 2004). DataAlgorithm + VisAlgorithm.
 
 #include <algorithm>
+#include <array>
+#include <chrono>
 #include <cmath>
 #include <complex>
+#include <cstdio>
 #include <fantom/algorithm.hpp>
 #include <fantom/datastructures/DomainFactory.hpp>
 #include <fantom/datastructures/interfaces/Field.hpp>
 #include <fantom/datastructures/domains/Grid.hpp>
+#include <fantom/datastructures/domains/PointSet.hpp>
 #include <fantom/datastructures/Function.hpp>
 #include <fantom/graphics.hpp>
 #include <fantom/math.hpp>
 #include <fantom/register.hpp>
 #include <fantom-plugins/utils/math/eigenvalues.hpp>
 #include <fantom-plugins/utils/Graphics/HelperFunctions.hpp>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <map>
 #include <memory>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <utility>
 #include <vector>
 #include <limits>
+#include "GlyphMesh.hpp"
+#include "ParallelFor.hpp"
+#include "RectilinearLattice.hpp"
 
 namespace aufgabe4_1
 {
@@ -25,6 +41,13 @@ namespace aufgabe4_1
     {
         constexpr double kMinEigenvalue = 1e-12;
         constexpr double kDefaultGamma = 2.5;
+        constexpr size_t kGlyphChunkSize = 64; // samples per parallel work item
+
+        // Tessellation levels of the adaptive mode: fraction of Resolution Theta/Phi per level (0 = full resolution).
+        constexpr int kNumLevels = 4;
+        constexpr double kLevelFraction[kNumLevels] = { 1.0, 0.75, 0.5, 0.35 };
+
+        int levelResolution( int res, int level ) { return std::max( 4, (int)std::lround( res * kLevelFraction[level] ) ); }
 
         struct WestinMetrics { double c_l, c_p, c_s; };
 
@@ -42,6 +65,15 @@ namespace aufgabe4_1
             return { ( lambda1 - lambda2 ) / sum, 2.0 * ( lambda2 - lambda3 ) / sum, 3.0 * lambda3 / sum };
         }
 
+        // Fractional anisotropy in [0,1] (0 = isotropic).
+        double fractionalAnisotropy( double lambda1, double lambda2, double lambda3 )
+        {
+            double norm = lambda1 * lambda1 + lambda2 * lambda2 + lambda3 * lambda3;
+            if( norm < kMinEigenvalue * kMinEigenvalue ) return 0.0;
+            double d12 = lambda1 - lambda2, d23 = lambda2 - lambda3, d31 = lambda3 - lambda1;
+            return std::sqrt( 0.5 * ( d12 * d12 + d23 * d23 + d31 * d31 ) / norm );
+        }
+
         // Alpha and beta control shape (cylinder vs disc vs sphere). Kindlmann: from Westin; else round cross-section.
         FormParameters computeFormParameters( double c_l, double c_p, double c_s, double gamma, bool useKindlmann )
         {
@@ -77,6 +109,47 @@ namespace aufgabe4_1
             return Vector3( nx, ny, nz );
         }
 
+        // Unit superquadric sampled on the theta/phi grid (normals normalized). Depends only on (alpha, beta) and the
+        // resolution, so glyphs with the same shape share it and only apply their own scale and rotation.
+        struct UnitShape
+        {
+            std::vector< Point3 > points;
+            std::vector< Vector3 > normals;
+        };
+
+        UnitShape makeUnitShape( double alpha, double beta, int resTheta, int resPhi )
+        {
+            UnitShape shape;
+            shape.points.reserve( ( resTheta + 1 ) * ( resPhi + 1 ) );
+            shape.normals.reserve( ( resTheta + 1 ) * ( resPhi + 1 ) );
+            for( int i = 0; i <= resTheta; ++i )
+            {
+                double theta = -M_PI + ( 2.0 * M_PI * i ) / resTheta;
+                for( int j = 0; j <= resPhi; ++j )
+                {
+                    double phi = -M_PI / 2.0 + ( M_PI * j ) / resPhi;
+                    shape.points.push_back( superquadricPoint( theta, phi, alpha, beta ) );
+                    shape.normals.push_back( normalized( superquadricNormal( theta, phi, alpha, beta ) ) );
+                }
+            }
+            return shape;
+        }
+
+        // Eigen analysis of one sample: clamped eigenvalues (largest first), right-handed eigenframe (v1 = main
+        // direction) and shape parameters. Samples outside the field have inside = false.
+        struct GlyphFrame
+        {
+            bool inside = false;
+            double l1 = 0.0, l2 = 0.0, l3 = 0.0;
+            Vector3 v1, v2, v3;
+            FormParameters form = { 1.0, 1.0 };
+            int level = 0;                    // tessellation level
+            const UnitShape* shape = nullptr; // table entry (null: exact shape per glyph)
+
+            // Degenerate tensors (all eigenvalues near zero) get no glyph.
+            bool valid() const { return inside && l1 >= kMinEigenvalue; }
+        };
+
         // Eigen solver can return complex numbers; for symmetric tensors we take the real part (or magnitude).
         double extractRealEigenvalue( const std::complex< double >& val, double threshold = 1e-9 )
         {
@@ -90,8 +163,456 @@ namespace aufgabe4_1
             return normalized( res );
         }
         
+        GlyphFrame analyzeTensor( const Matrix< 3 >& val, double gamma, bool useKindlmann )
+        {
+            // Tensor at this point. We need its eigenvalues (sizes) and eigenvectors (directions).
+            Tensor< double, 3, 3 > tensor( val );
+            auto eigensystem = fantom::math::getEigensystem< 3 >( tensor );
+
+            // Get real eigenvalues and eigenvectors; sort by eigenvalue (largest first).
+            std::vector< std::pair< double, Vector3 > > eigenPairs( 3 );
+            for( int i = 0; i < 3; ++i )
+            {
+                eigenPairs[i].first = extractRealEigenvalue( eigensystem.first[i] );
+                eigenPairs[i].second = extractRealEigenvector( eigensystem.second[i] );
+            }
+
+            // Sort by eigenvalue (descending)
+            std::sort( eigenPairs.begin(), eigenPairs.end(), []( const auto& a, const auto& b ) {
+                return a.first > b.first;
+            } );
+
+            GlyphFrame f;
+            f.inside = true;
+            f.l1 = std::max( 0.0, eigenPairs[0].first );
+            f.l2 = std::max( 0.0, eigenPairs[1].first );
+            f.l3 = std::max( 0.0, eigenPairs[2].first );
+            if( !f.valid() ) return f;
+
+            // Build orthonormal frame (v1 = main direction; v2, v3 perpendicular; right-handed).
+            f.v1 = normalized( eigenPairs[0].second );
+            f.v2 = normalized( eigenPairs[1].second - ( eigenPairs[1].second * f.v1 ) * f.v1 ); // Gram-Schmidt to ensure orthogonality
+            f.v3 = normalized( cross( f.v1, f.v2 ) );
+
+            // Shape parameters from Kindlmann paper (alpha, beta).
+            WestinMetrics m = computeWestinMetrics( f.l1, f.l2, f.l3 );
+            f.form = computeFormParameters( m.c_l, m.c_p, m.c_s, gamma, useKindlmann );
+            return f;
+        }
+
+        // Color from main direction.
+        Color glyphColor( const GlyphFrame& f ) { return Color( std::abs( f.v1[0] ), std::abs( f.v1[1] ), std::abs( f.v1[2] ), 1.0f ); }
+
         PointF<3> toPointF( const Point3& p ) { return PointF<3>( (float)p[0], (float)p[1], (float)p[2] ); }
         VectorF<3> toVectorF( const Vector3& v ) { return VectorF<3>( (float)v[0], (float)v[1], (float)v[2] ); }
+
+        // Vertex storage for the generator's double mesh and the renderer's float buffers.
+        inline void storeVertex( Vector3& out, const Vector3& v ) { out = v; }
+        inline void storeVertex( VectorF< 3 >& out, const Vector3& v ) { out = toVectorF( v ); }
+
+        // Writes the glyph's (resTheta+1)×(resPhi+1) vertices and its triangles at the given offsets (vertex indices
+        // start at baseIndex), so glyphs can be written in any order and on any thread.
+        template< typename V, typename I >
+        void writeGlyph( const GlyphFrame& f, const UnitShape& shape, const Point3& p, double size, const Color& color, int resTheta,
+                         int resPhi, size_t baseIndex, V* vertices, V* normals, Color* colors, I* indices )
+        {
+            // Unit superquadric z-axis → principal eigenvector; scale by eigenvalues, rotate into the eigenframe (Z→v1).
+            // Normals take the inverse scale.
+            const Vector3 ax = size * f.l2 * f.v2, ay = size * f.l3 * f.v3, az = size * f.l1 * f.v1;
+            const Vector3 nx = ( f.l2 > 1e-9 ) ? f.v2 / f.l2 : f.v2;
+            const Vector3 ny = ( f.l3 > 1e-9 ) ? f.v3 / f.l3 : f.v3;
+            const Vector3 nz = ( f.l1 > 1e-9 ) ? f.v1 / f.l1 : f.v1;
+            for( size_t k = 0; k < shape.points.size(); ++k )
+            {
+                const Point3& u = shape.points[k];
+                const Vector3& n = shape.normals[k];
+                storeVertex( vertices[k], p + u[0] * ax + u[1] * ay + u[2] * az );
+                storeVertex( normals[k], normalized( n[0] * nx + n[1] * ny + n[2] * nz ) );
+                colors[k] = color;
+            }
+
+            // Connect the vertex grid into triangles (each quad becomes two triangles).
+            for( int i = 0; i < resTheta; ++i )
+            {
+                for( int j = 0; j < resPhi; ++j )
+                {
+                    I i00 = static_cast< I >( baseIndex + i * ( resPhi + 1 ) + j );
+                    I i01 = static_cast< I >( baseIndex + i * ( resPhi + 1 ) + ( j + 1 ) );
+                    I i10 = static_cast< I >( baseIndex + ( i + 1 ) * ( resPhi + 1 ) + j );
+                    I i11 = static_cast< I >( baseIndex + ( i + 1 ) * ( resPhi + 1 ) + ( j + 1 ) );
+
+                    *indices++ = i00; *indices++ = i01; *indices++ = i10;
+                    *indices++ = i01; *indices++ = i11; *indices++ = i10;
+                }
+            }
+        }
+
+        // Unit shapes by tessellation level and quantized (alpha, beta), kept across executions as long as the resolution and
+        // the table resolution stay the same. Resolution 0 disables the table (exact shape per glyph).
+        class UnitShapeTable
+        {
+        public:
+            void configure( int resTheta, int resPhi, int resolution )
+            {
+                if( mKey == std::make_tuple( resTheta, resPhi, resolution ) ) return;
+                mShapes.clear();
+                mKey = std::make_tuple( resTheta, resPhi, resolution );
+            }
+
+            int resolution() const { return std::get< 2 >( mKey ); }
+            size_t size() const { return mShapes.size(); }
+
+            // Points every frame at its table cell; missing cells are built in parallel first. False if aborted.
+            bool assign( std::vector< GlyphFrame >& frames, size_t numThreads, const volatile bool& abortFlag )
+            {
+                const int res = resolution();
+                if( res <= 0 ) return true;
+                // Exponents are kept at least one step above 0, where the superquadric degenerates.
+                auto cellOf = [res]( const GlyphFrame& f ) {
+                    return Cell( f.level, std::max( 1L, std::lround( f.form.alpha * res ) ), std::max( 1L, std::lround( f.form.beta * res ) ) );
+                };
+                std::set< Cell > missingCells;
+                for( const GlyphFrame& f : frames )
+                {
+                    auto cell = cellOf( f );
+                    if( !mShapes.count( cell ) ) missingCells.insert( cell );
+                }
+                const std::vector< Cell > missing( missingCells.begin(), missingCells.end() );
+                std::vector< UnitShape > built( missing.size() );
+                parallelFor( missing.size(), numThreads, 1, abortFlag,
+                    [&]( size_t, size_t begin, size_t end ) {
+                        for( size_t c = begin; c < end; ++c )
+                        {
+                            const int level = std::get< 0 >( missing[c] );
+                            built[c] = makeUnitShape( double( std::get< 1 >( missing[c] ) ) / res, double( std::get< 2 >( missing[c] ) ) / res,
+                                                      levelResolution( std::get< 0 >( mKey ), level ), levelResolution( std::get< 1 >( mKey ), level ) );
+                        }
+                    },
+                    []( size_t ) {} );
+                if( abortFlag ) return false;
+                for( size_t c = 0; c < missing.size(); ++c ) mShapes.emplace( missing[c], std::move( built[c] ) );
+                for( GlyphFrame& f : frames ) f.shape = &mShapes.at( cellOf( f ) );
+                return true;
+            }
+
+        private:
+            using Cell = std::tuple< int, long, long >; // level, alpha and beta step
+            std::map< Cell, UnitShape > mShapes;
+            std::tuple< int, int, int > mKey{ 0, 0, 0 }; // resolution theta, phi and table the shapes were made for
+        };
+
+        // Samples of one generator run as a box of sample indices: the resampling lattice (origin + index * spacing, i slowest)
+        // or native grid points (value index per sample; x fastest on rectilinear grids, else every stride-th point along the
+        // first index). Brick mode collects one sub-box at a time.
+        struct SampleLattice
+        {
+            std::array< size_t, 3 > dims = { { 0, 0, 0 } };
+            Point3 origin;
+            double spacing = 0.0;
+            bool native = false;
+            const RectilinearLattice* lattice = nullptr; // native mode on a rectilinear grid
+            size_t stride = 1;
+
+            size_t size() const { return dims[0] * dims[1] * dims[2]; }
+
+            // Whether sample index (in the order of a full-box collect) lies on the sub-lattice of every stride-th sample per axis.
+            bool onSubLattice( size_t index, size_t stride ) const
+            {
+                std::array< size_t, 3 > ijk;
+                if( native ) ijk = { { index % dims[0], ( index / dims[0] ) % dims[1], index / ( dims[0] * dims[1] ) } };
+                else ijk = { { index / ( dims[1] * dims[2] ), ( index / dims[2] ) % dims[1], index % dims[2] } };
+                return ijk[0] % stride == 0 && ijk[1] % stride == 0 && ijk[2] % stride == 0;
+            }
+
+            template< typename Points >
+            void collect( const std::array< size_t, 3 >& lo, const std::array< size_t, 3 >& hi, const Points& gridPoints,
+                          std::vector< Point3 >& points, std::vector< size_t >& values ) const
+            {
+                points.clear();
+                values.clear();
+                if( !native )
+                {
+                    for( size_t i = lo[0]; i < hi[0]; ++i )
+                        for( size_t j = lo[1]; j < hi[1]; ++j )
+                            for( size_t k = lo[2]; k < hi[2]; ++k )
+                                points.push_back( origin + Vector3( i*spacing, j*spacing, k*spacing ) );
+                    return;
+                }
+                for( size_t k = lo[2]; k < hi[2]; ++k )
+                    for( size_t j = lo[1]; j < hi[1]; ++j )
+                        for( size_t i = lo[0]; i < hi[0]; ++i )
+                            values.push_back( lattice ? lattice->pointIndex( i * stride, j * stride, k * stride ) : i * stride );
+                points.reserve( values.size() );
+                for( size_t v : values ) points.push_back( gridPoints[v] );
+            }
+        };
+
+        // Binary PLY written brick by brick: vertices go to the file, faces to a side file that is appended on finish, and the
+        // element counts are patched into the fixed-width header. Memory stays at one brick. Values are written in host order,
+        // so big-endian hosts are refused; a stream destroyed before finish (abort, error) removes its files.
+        class PlyMeshStream
+        {
+        public:
+            explicit PlyMeshStream( const std::string& path ) : mPath( path ), mFacesPath( path + ".faces" )
+            {
+                const unsigned int one = 1;
+                if( *reinterpret_cast< const unsigned char* >( &one ) != 1 )
+                    throw std::logic_error( "Brick File: binary little-endian PLY is only written on little-endian hosts." );
+                mVertices.open( path, std::ios::binary | std::ios::trunc );
+                mFaces.open( mFacesPath, std::ios::binary | std::ios::trunc );
+                if( !mVertices || !mFaces ) throw std::logic_error( "Cannot write Brick File '" + path + "'." );
+                writeHeader();
+            }
+
+            ~PlyMeshStream()
+            {
+                if( mFinished ) return;
+                mFaces.close();
+                mVertices.close();
+                std::remove( mFacesPath.c_str() );
+                std::remove( mPath.c_str() );
+            }
+
+            size_t numVertices() const { return mNumVertices; }
+            size_t numFaces() const { return mNumFaces; }
+
+            // Appends one brick; its indices refer to its own vertices.
+            void append( const std::vector< PointF< 3 > >& vertices, const std::vector< VectorF< 3 > >& normals,
+                         const std::vector< Color >& colors, const std::vector< unsigned int >& indices )
+            {
+                if( mNumVertices + vertices.size() > std::numeric_limits< unsigned int >::max() )
+                    throw std::logic_error( "Brick File too large for 32-bit indices." );
+                for( size_t v = 0; v < vertices.size(); ++v )
+                {
+                    const float record[6] = { vertices[v][0], vertices[v][1], vertices[v][2], normals[v][0], normals[v][1], normals[v][2] };
+                    const unsigned char rgb[3] = { toByte( colors[v].r() ), toByte( colors[v].g() ), toByte( colors[v].b() ) };
+                    mVertices.write( reinterpret_cast< const char* >( record ), sizeof( record ) );
+                    mVertices.write( reinterpret_cast< const char* >( rgb ), sizeof( rgb ) );
+                }
+                const unsigned int base = static_cast< unsigned int >( mNumVertices );
+                for( size_t t = 0; t + 2 < indices.size(); t += 3 )
+                {
+                    const unsigned char corners = 3;
+                    const unsigned int face[3] = { base + indices[t], base + indices[t + 1], base + indices[t + 2] };
+                    mFaces.write( reinterpret_cast< const char* >( &corners ), 1 );
+                    mFaces.write( reinterpret_cast< const char* >( face ), sizeof( face ) );
+                }
+                mNumVertices += vertices.size();
+                mNumFaces += indices.size() / 3;
+            }
+
+            // Appends the faces, writes the final counts and removes the side file.
+            void finish()
+            {
+                mFaces.close();
+                if( mNumFaces > 0 )
+                {
+                    std::ifstream faces( mFacesPath, std::ios::binary );
+                    mVertices << faces.rdbuf();
+                }
+                std::remove( mFacesPath.c_str() );
+                mVertices.seekp( 0 );
+                writeHeader();
+                mVertices.close();
+                if( mVertices.fail() ) throw std::logic_error( "Writing the Brick File failed." );
+                mFinished = true;
+            }
+
+        private:
+            static unsigned char toByte( double c ) { return static_cast< unsigned char >( std::lround( 255.0 * std::max( 0.0, std::min( 1.0, c ) ) ) ); }
+
+            void writeHeader()
+            {
+                mVertices << "ply\nformat binary_little_endian 1.0\n"
+                          << "element vertex " << std::setw( 10 ) << std::setfill( '0' ) << mNumVertices << "\n"
+                          << "property float x\nproperty float y\nproperty float z\n"
+                          << "property float nx\nproperty float ny\nproperty float nz\n"
+                          << "property uchar red\nproperty uchar green\nproperty uchar blue\n"
+                          << "element face " << std::setw( 10 ) << std::setfill( '0' ) << mNumFaces << "\n"
+                          << "property list uchar uint vertex_indices\nend_header\n";
+            }
+
+            std::string mPath, mFacesPath;
+            std::ofstream mVertices, mFaces;
+            size_t mNumVertices = 0, mNumFaces = 0;
+            bool mFinished = false;
+        };
+
+        // Counters of the eigen analysis over all samples (for the log).
+        struct SampleStats
+        {
+            size_t valid = 0, skipped = 0, culled = 0;
+            double minEval = std::numeric_limits< double >::max();
+            double maxEval = std::numeric_limits< double >::lowest();
+        };
+
+        // A budget's part for a brick holding the given fraction of all samples (0 = no limit stays unlimited).
+        size_t budgetShare( size_t budget, double fraction )
+        {
+            return ( budget == 0 ) ? 0 : std::max< size_t >( 1, static_cast< size_t >( std::ceil( budget * fraction ) ) );
+        }
+
+        // The glyphs to tessellate, one entry per glyph: where, in which frame and shape, how large, which color.
+        struct GlyphSet
+        {
+            std::vector< Point3 > centers;
+            std::vector< GlyphFrame > frames;
+            std::vector< double > sizes;
+            std::vector< Color > colors;
+        };
+
+        // Culling measure of a valid glyph: c_l + c_p (= 1 - c_s) or FA.
+        double anisotropyOf( const GlyphFrame& f, bool useFA )
+        {
+            if( useFA ) return fractionalAnisotropy( f.l1, f.l2, f.l3 );
+            WestinMetrics m = computeWestinMetrics( f.l1, f.l2, f.l3 );
+            return m.c_l + m.c_p;
+        }
+
+        // Glyph budget: keeps the maxGlyphs most anisotropic glyphs (ties by sample order) in sample order.
+        void keepMostAnisotropic( GlyphSet& glyphs, const std::vector< double >& anisotropy, size_t maxGlyphs )
+        {
+            if( maxGlyphs == 0 || glyphs.frames.size() <= maxGlyphs ) return;
+            std::vector< size_t > order( glyphs.frames.size() );
+            for( size_t g = 0; g < order.size(); ++g ) order[g] = g;
+            std::stable_sort( order.begin(), order.end(), [&]( size_t a, size_t b ) { return anisotropy[a] > anisotropy[b]; } );
+            order.resize( maxGlyphs );
+            std::sort( order.begin(), order.end() );
+
+            GlyphSet kept;
+            for( size_t g : order )
+            {
+                kept.centers.push_back( glyphs.centers[g] );
+                kept.frames.push_back( glyphs.frames[g] );
+                kept.sizes.push_back( glyphs.sizes[g] );
+                kept.colors.push_back( glyphs.colors[g] );
+            }
+            glyphs = std::move( kept );
+        }
+
+        // Mean distance of count points spread over the box [lo, hi] (degenerate axes ignored; 0 for fewer than two).
+        double spacingInBox( const Point3& lo, const Point3& hi, size_t count )
+        {
+            if( count < 2 ) return 0.0;
+            Vector3 extent = hi - lo;
+            int dims = 0;
+            double volume = 1.0;
+            for( int d = 0; d < 3; ++d )
+                if( extent[d] > 1e-12 ) { volume *= extent[d]; ++dims; }
+            return ( dims > 0 ) ? std::pow( volume / count, 1.0 / dims ) : 0.0;
+        }
+
+        // Mean point distance estimated from the bounding box of the points.
+        double estimateSpacing( const std::vector< Point3 >& points )
+        {
+            if( points.empty() ) return 0.0;
+            Point3 lo = points[0], hi = lo;
+            for( const Point3& c : points )
+                for( int d = 0; d < 3; ++d )
+                {
+                    lo[d] = std::min( lo[d], c[d] );
+                    hi[d] = std::max( hi[d], c[d] );
+                }
+            return spacingInBox( lo, hi, points.size() );
+        }
+
+        // Adaptive mode: the coarsest level that still shows the glyph's shape. Round shapes (alpha and beta near 1, c_s ≈ 1)
+        // look the same with few segments, sharp edges (small exponents at high gamma) need the full grid; glyphs much
+        // smaller than the sample spacing drop one level more.
+        int adaptiveLevel( const GlyphFrame& f, double size, double spacing )
+        {
+            static const double kRoundness[] = { 0.25, 0.5, 0.8 };
+            const double roundness = std::min( f.form.alpha, f.form.beta );
+            int level = 0;
+            while( level < kNumLevels - 1 && roundness > kRoundness[level] ) ++level;
+            if( spacing > 0.0 && size * f.l1 < 0.2 * spacing ) ++level;
+            return std::min( level, kNumLevels - 1 );
+        }
+
+        size_t glyphTriangles( int resTheta, int resPhi, int level )
+        {
+            return size_t( 2 ) * levelResolution( resTheta, level ) * levelResolution( resPhi, level );
+        }
+
+        // Per-glyph levels: adaptive (or full resolution), then coarsened one level per sweep, smallest glyphs first,
+        // until the triangles fit into maxTriangles (0 = no limit) or every glyph is at the coarsest level.
+        void chooseLevels( GlyphSet& glyphs, int resTheta, int resPhi, bool adaptive, double spacing, size_t maxTriangles )
+        {
+            std::vector< GlyphFrame >& frames = glyphs.frames;
+            size_t total = 0;
+            for( size_t g = 0; g < frames.size(); ++g )
+            {
+                frames[g].level = adaptive ? adaptiveLevel( frames[g], glyphs.sizes[g], spacing ) : 0;
+                total += glyphTriangles( resTheta, resPhi, frames[g].level );
+            }
+            if( maxTriangles == 0 || total <= maxTriangles ) return;
+
+            std::vector< size_t > order( frames.size() );
+            for( size_t g = 0; g < order.size(); ++g ) order[g] = g;
+            std::stable_sort( order.begin(), order.end(), [&]( size_t a, size_t b ) {
+                return glyphs.sizes[a] * frames[a].l1 < glyphs.sizes[b] * frames[b].l1;
+            } );
+            bool changed = true;
+            while( total > maxTriangles && changed )
+            {
+                changed = false;
+                for( size_t g : order )
+                {
+                    GlyphFrame& f = frames[g];
+                    if( f.level == kNumLevels - 1 ) continue;
+                    total -= glyphTriangles( resTheta, resPhi, f.level );
+                    ++f.level;
+                    total += glyphTriangles( resTheta, resPhi, f.level );
+                    changed = true;
+                    if( total <= maxTriangles ) break;
+                }
+            }
+        }
+
+        // Tessellates all glyphs into one triangle mesh. A counting pass and prefix sum give every glyph its own ranges,
+        // so the fill runs on all threads and the mesh equals the serial one for any thread count. Frames without a
+        // table shape get their exact shape. False if aborted.
+        template< typename V, typename I, typename OnProgress >
+        bool tessellateGlyphs( const GlyphSet& glyphs, int resTheta, int resPhi, size_t numThreads, const volatile bool& abortFlag,
+                               std::vector< V >& vertices, std::vector< V >& normals, std::vector< Color >& colors,
+                               std::vector< I >& indices, OnProgress&& onProgress )
+        {
+            const size_t count = glyphs.frames.size();
+            std::vector< size_t > firstVertex( count + 1, 0 ), firstIndex( count + 1, 0 );
+            for( size_t g = 0; g < count; ++g )
+            {
+                const int level = glyphs.frames[g].level;
+                const size_t rt = levelResolution( resTheta, level ), rp = levelResolution( resPhi, level );
+                firstVertex[g + 1] = firstVertex[g] + ( rt + 1 ) * ( rp + 1 );
+                firstIndex[g + 1] = firstIndex[g] + 6 * rt * rp;
+            }
+            if( firstVertex[count] > std::numeric_limits< I >::max() ) throw std::logic_error( "Glyph mesh too large for its index type." );
+            vertices.resize( firstVertex[count] );
+            normals.resize( vertices.size() );
+            colors.resize( vertices.size() );
+            indices.resize( firstIndex[count] );
+
+            std::vector< UnitShape > exactShapes( numThreads );
+            parallelFor( count, numThreads, kGlyphChunkSize, abortFlag,
+                [&]( size_t thread, size_t begin, size_t end ) {
+                    for( size_t g = begin; g < end; ++g )
+                    {
+                        const GlyphFrame& f = glyphs.frames[g];
+                        const int rt = levelResolution( resTheta, f.level ), rp = levelResolution( resPhi, f.level );
+                        const UnitShape* shape = f.shape;
+                        if( !shape )
+                        {
+                            exactShapes[thread] = makeUnitShape( f.form.alpha, f.form.beta, rt, rp );
+                            shape = &exactShapes[thread];
+                        }
+                        const size_t base = firstVertex[g];
+                        writeGlyph( f, *shape, glyphs.centers[g], glyphs.sizes[g], glyphs.colors[g], rt, rp, base,
+                                    &vertices[base], &normals[base], &colors[base], &indices[firstIndex[g]] );
+                    }
+                },
+                onProgress );
+            return !abortFlag;
+        }
     }
 
     class SuperquadricTensorGlyphs : public DataAlgorithm
@@ -107,10 +628,25 @@ namespace aufgabe4_1
                 add< bool >( "Use Kindlmann Shape", "Paper shape (alpha/beta from anisotropy); off = round cross-section", true );
                 add< int >( "Resolution Theta", "Theta resolution", 20 );
                 add< int >( "Resolution Phi", "Phi resolution", 20 );
+                add< int >( "Shape Table Resolution", "Steps per unit of alpha/beta for shared unit shapes (0 = exact shape per glyph)", 0 );
                 add< int >( "Sample Count", "Grid sampling resolution", 10 );
+                add< bool >( "Native Grid", "One glyph per grid point, read from the stored values (no resampling; Sample Count and Time unused)", false );
+                add< int >( "Grid Stride", "Native Grid: use every n-th point per axis", 1 );
                 add< double >( "Time", "Evaluation time", 0.0 );
                 add< bool >( "Normalize to cell", "Scale each glyph to fit cell (no overlap)", false );
                 add< double >( "Cell fill", "Fraction of cell size when normalized (0.5–1.0)", 0.8 );
+                add< int >( "Threads", "Worker threads for glyph generation (0 = all cores, 1 = serial)", 0 );
+                add< double >( "Min Anisotropy", "Skip nearly isotropic tensors below this c_l + c_p (or FA) (0 = keep all)", 0.0 );
+                add< bool >( "Cull by FA", "Use fractional anisotropy for Min Anisotropy and Max Glyphs; off = c_l + c_p", false );
+                add< int >( "Max Glyphs", "Keep only the most anisotropic glyphs (0 = no limit)", 0 );
+                add< bool >( "Generate Mesh", "Tessellate here; off = only the glyph parameters (the renderer tessellates)", true );
+                add< int >( "Progressive Passes", "Coarse-to-fine passes over every 2^n-th sample, each published as it completes (0 = off; not in brick mode)", 0 );
+                add< double >( "Progressive Interval", "Minimum seconds between intermediate results after the first pass (0 = after every pass)", 0.0 );
+                add< int >( "Brick Size", "Stream the mesh brick by brick (this many samples per axis) into the Brick File; no other outputs (0 = off)", 0 );
+                add< std::string >( "Brick File", "Binary PLY file the bricked mesh is streamed into (required with Brick Size)", "" );
+                add< bool >( "Output Grid", "Publish the mesh as Grid with Color/Normals (double precision, for analysis) instead of the float Render Mesh", false );
+                add< bool >( "Adaptive Resolution", "Fewer segments for round and small glyphs", false );
+                add< int >( "Max Triangles", "Triangle budget; smallest glyphs are coarsened first (0 = no limit)", 0 );
             }
         };
 
@@ -118,9 +654,17 @@ namespace aufgabe4_1
         {
             DataOutputs( fantom::DataOutputs::Control& control ) : DataAlgorithm::DataOutputs( control )
             {
+                add< const GlyphMesh >( "Render Mesh" );
                 add< const Grid< 3 > >( "Glyph Mesh" );
                 add< const Function< Color > >( "Color" );
                 add< const Function< Vector3 > >( "Normals" );
+                // Parametric glyphs, one value per glyph center.
+                add< const PointSet< 3 > >( "Glyph Centers" );
+                add< const Function< Matrix< 3 > > >( "Glyph Frame" );
+                add< const Function< Vector3 > >( "Glyph Eigenvalues" );
+                add< const Function< Vector2 > >( "Glyph Shape" );
+                add< const Function< Color > >( "Glyph Color" );
+                add< const Function< double > >( "Glyph Size" );
             }
         };
 
@@ -143,19 +687,21 @@ namespace aufgabe4_1
 
             debugLog() << "Input Grid has " << grid->points().size() << " points." << std::endl;
 
-            // Evaluator gives us the tensor at any point.
-            auto evaluator = field->makeEvaluator();
-            if( !evaluator ) { clearResults(); return; }
-
             double time = options.get< double >( "Time" );
             double glyphScale = options.get< double >( "Glyph Scale" );
             double gamma = options.get< double >( "Sharpness Parameter γ" );
             bool useKindlmann = options.get< bool >( "Use Kindlmann Shape" );
             int resTheta = std::max( 4, options.get< int >( "Resolution Theta" ) );
             int resPhi = std::max( 4, options.get< int >( "Resolution Phi" ) );
+            int shapeTableRes = std::max( 0, options.get< int >( "Shape Table Resolution" ) );
             int sampleCount = std::max( 1, options.get< int >( "Sample Count" ) );
+            bool nativeGrid = options.get< bool >( "Native Grid" );
+            size_t gridStride = static_cast< size_t >( std::max( 1, options.get< int >( "Grid Stride" ) ) );
             bool normalizeToCell = options.get< bool >( "Normalize to cell" );
             double cellFill = std::max( 0.01, std::min( 1.0, options.get< double >( "Cell fill" ) ) );
+            double minAnisotropy = std::max( 0.0, options.get< double >( "Min Anisotropy" ) );
+            bool cullByFA = options.get< bool >( "Cull by FA" );
+            size_t maxGlyphs = static_cast< size_t >( std::max( 0, options.get< int >( "Max Glyphs" ) ) );
 
             debugLog() << "Parameters:" << std::endl;
             debugLog() << "  Time: " << time << std::endl;
@@ -164,9 +710,13 @@ namespace aufgabe4_1
             debugLog() << "  Use Kindlmann: " << (useKindlmann ? "Yes" : "No") << std::endl;
             debugLog() << "  Res Theta: " << resTheta << std::endl;
             debugLog() << "  Res Phi: " << resPhi << std::endl;
-            debugLog() << "  Sample Count: " << sampleCount << std::endl;
+            debugLog() << "  Shape Table Resolution: " << shapeTableRes << std::endl;
+            if( nativeGrid ) debugLog() << "  Native Grid, stride " << gridStride << std::endl;
+            else debugLog() << "  Sample Count: " << sampleCount << std::endl;
             debugLog() << "  Normalize to cell: " << ( normalizeToCell ? "Yes" : "No" ) << std::endl;
             if( normalizeToCell ) debugLog() << "  Cell fill: " << cellFill << std::endl;
+            debugLog() << "  Min Anisotropy: " << minAnisotropy << ( cullByFA ? " (FA)" : " (c_l + c_p)" ) << std::endl;
+            if( maxGlyphs > 0 ) debugLog() << "  Max Glyphs: " << maxGlyphs << std::endl;
 
             // Bounding Box & Sampling
             const auto& gridPoints = grid->points();
@@ -180,147 +730,240 @@ namespace aufgabe4_1
             
             debugLog() << "Grid Bounds: [" << gridMin << "] to [" << gridMax << "]" << std::endl;
 
-            // Spacing and sample counts per dimension (0 if domain is degenerate in that axis).
-            Vector3 gridSize = gridMax - gridMin;
-            double maxDim = std::max( { gridSize[0], gridSize[1], gridSize[2] } );
-            double spacing = maxDim / static_cast< double >( sampleCount + 1 );
-            int countX = ( gridSize[0] < 1e-6 ) ? 0 : sampleCount;
-            int countY = ( gridSize[1] < 1e-6 ) ? 0 : sampleCount;
-            int countZ = ( gridSize[2] < 1e-6 ) ? 0 : sampleCount;
-
-            // Fill (countX+1)×(countY+1)×(countZ+1) sample positions.
-            std::vector< Point3 > samplePoints;
-            for( int i = 0; i <= countX; ++i )
-                for( int j = 0; j <= countY; ++j )
-                    for( int k = 0; k <= countZ; ++k )
-                        samplePoints.push_back( gridMin + Vector3( i*spacing, j*spacing, k*spacing ) );
-
-            // We will append one mesh per glyph: vertices, normals, colors, and triangle indices.
-            std::vector< Point3 > vertices;
-            std::vector< Color > colors;
-            std::vector< Vector3 > normals;
-            std::vector< size_t > indices;
-
-            size_t validTensors = 0;
-            size_t skippedTensors = 0;
-
-            double minEval = std::numeric_limits<double>::max();
-            double maxEval = std::numeric_limits<double>::lowest();
-
-            Algorithm::Progress progress( *this, "Generating Glyphs", samplePoints.size() );
-
-            for( size_t i = 0; i < samplePoints.size(); ++i )
+            // Sample lattice: resampled at Sample Count, or the grid's own points.
+            RectilinearLattice lattice;
+            SampleLattice samples;
+            double spacing = 0.0;
+            if( nativeGrid )
             {
-                progress = i;
-                const auto& p = samplePoints[i];
-
-                if( abortFlag ) break;
-                evaluator->reset( p, time );
-                if( !*evaluator ) continue;
+                if( function->values().size() != gridPoints.size() ) throw std::logic_error( "Native Grid needs point data." );
+                samples.native = true;
+                samples.stride = gridStride;
 
-                // Tensor at this point. We need its eigenvalues (sizes) and eigenvectors (directions).
-                Matrix< 3 > val = evaluator->value();
-                Tensor< double, 3, 3 > tensor( val );
-                auto eigensystem = fantom::math::getEigensystem< 3 >( tensor );
-
-                // Get real eigenvalues and eigenvectors; sort by eigenvalue (largest first).
-                std::vector< std::pair< double, Vector3 > > eigenPairs( 3 );
-                for( int i = 0; i < 3; ++i )
+                // Rectilinear grids are strided per axis; any other grid every gridStride-th point.
+                if( lattice.build( gridPoints ) )
                 {
-                    eigenPairs[i].first = extractRealEigenvalue( eigensystem.first[i] );
-                    eigenPairs[i].second = extractRealEigenvector( eigensystem.second[i] );
+                    samples.lattice = &lattice;
+                    spacing = std::numeric_limits< double >::max();
+                    for( int d = 0; d < 3; ++d )
+                    {
+                        const auto& axis = lattice.axis( d );
+                        samples.dims[d] = ( axis.size() + gridStride - 1 ) / gridStride;
+                        if( axis.size() > 1 ) spacing = std::min( spacing, gridStride * ( axis.back() - axis.front() ) / ( axis.size() - 1 ) );
+                    }
+                    if( spacing == std::numeric_limits< double >::max() ) spacing = 0.0;
                 }
-
-                // Sort by eigenvalue (descending)
-                std::sort( eigenPairs.begin(), eigenPairs.end(), []( const auto& a, const auto& b ) {
-                    return a.first > b.first;
-                } );
-
-                double l1 = std::max( 0.0, eigenPairs[0].first );
-                double l2 = std::max( 0.0, eigenPairs[1].first );
-                double l3 = std::max( 0.0, eigenPairs[2].first );
-
-                minEval = std::min( minEval, l3 );
-                maxEval = std::max( maxEval, l1 );
-
-                // Skip degenerate tensors (all eigenvalues near zero).
-                if( l1 < kMinEigenvalue ) {
-                    skippedTensors++;
-                    continue;
+                else
+                {
+                    samples.dims = { { ( gridPoints.size() + gridStride - 1 ) / gridStride, 1, 1 } };
                 }
-                validTensors++;
-
-                Vector3 v1 = eigenPairs[0].second;
-                Vector3 v2 = eigenPairs[1].second;
-                Vector3 v3 = eigenPairs[2].second;
-
-                // Build orthonormal frame (v1 = main direction; v2, v3 perpendicular; right-handed).
-                v1 = normalized( v1 );
-                v2 = normalized( v2 - ( v2 * v1 ) * v1 ); // Gram-Schmidt to ensure orthogonality
-                v3 = normalized( cross( v1, v2 ) );
-
-                // Shape parameters from Kindlmann paper (alpha, beta) and color from main direction.
-                WestinMetrics m = computeWestinMetrics( l1, l2, l3 );
-                FormParameters fp = computeFormParameters( m.c_l, m.c_p, m.c_s, gamma, useKindlmann );
-                Color glyphColor( std::abs( v1[0] ), std::abs( v1[1] ), std::abs( v1[2] ), 1.0f );
-
-                // Optional: scale this glyph so it fits in its cell (no overlap with neighbors).
-                double scaleFactor = 1.0;
-                if( normalizeToCell && l1 >= kMinEigenvalue && spacing > 1e-12 )
+                if( spacing == 0.0 ) spacing = spacingInBox( gridMin, gridMax, samples.size() );
+            }
+            else
+            {
+                // Spacing and sample counts per dimension (0 if domain is degenerate in that axis).
+                Vector3 gridSize = gridMax - gridMin;
+                double maxDim = std::max( { gridSize[0], gridSize[1], gridSize[2] } );
+                spacing = maxDim / static_cast< double >( sampleCount + 1 );
+                int countX = ( gridSize[0] < 1e-6 ) ? 0 : sampleCount;
+                int countY = ( gridSize[1] < 1e-6 ) ? 0 : sampleCount;
+                int countZ = ( gridSize[2] < 1e-6 ) ? 0 : sampleCount;
+
+                // (countX+1)×(countY+1)×(countZ+1) sample positions.
+                samples.origin = gridMin;
+                samples.spacing = spacing;
+                samples.dims = { { size_t( countX + 1 ), size_t( countY + 1 ), size_t( countZ + 1 ) } };
+            }
+            const size_t totalSamples = samples.size();
+
+            // Brick mode streams the mesh into the Brick File, so it needs Generate Mesh and a file.
+            const bool generateMesh = options.get< bool >( "Generate Mesh" );
+            const size_t brickSize = generateMesh ? static_cast< size_t >( std::max( 0, options.get< int >( "Brick Size" ) ) ) : 0;
+            const std::string brickFile = options.get< std::string >( "Brick File" );
+            if( brickSize > 0 && brickFile.empty() ) throw std::logic_error( "Brick Size needs a Brick File." );
+            std::array< size_t, 3 > brickDims = samples.dims, brickCounts = { { 1, 1, 1 } };
+            if( brickSize > 0 )
+                for( int d = 0; d < 3; ++d )
                 {
-                    double targetRadius = 0.5 * spacing * cellFill;
-                    scaleFactor = targetRadius / ( glyphScale * l1 );
+                    brickDims[d] = std::min( brickSize, samples.dims[d] );
+                    brickCounts[d] = ( samples.dims[d] + brickDims[d] - 1 ) / brickDims[d];
                 }
 
-                size_t baseIndex = vertices.size();
+            // Evaluator gives us the tensor at any point; one per worker thread (native mode reads the values directly).
+            const size_t numThreads = resolveThreadCount( options.get< int >( "Threads" ), brickDims[0] * brickDims[1] * brickDims[2], kGlyphChunkSize );
+            std::vector< std::unique_ptr< FieldEvaluator< 3, Matrix< 3 > > > > evaluators;
+            for( size_t t = 0; t < numThreads && !nativeGrid; ++t )
+            {
+                evaluators.push_back( field->makeEvaluator() );
+                if( !evaluators.back() ) { clearResults(); return; }
+            }
+            debugLog() << "Generating " << totalSamples << " samples with " << numThreads << " thread(s)." << std::endl;
 
-                // Sample the unit superquadric with theta/phi; scale by l1,l2,l3; rotate to eigenframe. Each sample = one vertex + normal + color.
-                for( int i = 0; i <= resTheta; ++i )
+            SampleStats stats;
+            std::vector< Point3 > samplePoints;
+            std::vector< size_t > sampleValues; // native mode: index into the function's values per sample
+            std::vector< GlyphFrame > frames;
+
+            // Pass 1: eigen analysis of the collected samples by index (all of them, or only those in subset). False if aborted.
+            auto analyzeFrames = [&]( const std::vector< size_t >* subset, const std::function< void( size_t ) >& onProgress ) {
+                const auto& values = function->values();
+                parallelFor( subset ? subset->size() : samplePoints.size(), numThreads, kGlyphChunkSize, abortFlag,
+                    [&]( size_t thread, size_t begin, size_t end ) {
+                        for( size_t n = begin; n < end; ++n )
+                        {
+                            const size_t i = subset ? ( *subset )[n] : n;
+                            if( nativeGrid )
+                            {
+                                frames[i] = analyzeTensor( values[sampleValues[i]], gamma, useKindlmann );
+                                continue;
+                            }
+                            auto& evaluator = evaluators[thread];
+                            evaluator->reset( samplePoints[i], time );
+                            if( *evaluator ) frames[i] = analyzeTensor( evaluator->value(), gamma, useKindlmann );
+                        }
+                    },
+                    onProgress );
+                return !abortFlag;
+            };
+
+            // Reductions in sample order (only over the analyzed samples if given); the valid, anisotropic samples become glyphs.
+            auto collectGlyphs = [&]( const std::vector< char >* analyzed, GlyphSet& glyphs, std::vector< double >& anisotropy, SampleStats& counts ) {
+                for( size_t i = 0; i < frames.size(); ++i )
                 {
-                    double theta = -M_PI + ( 2.0 * M_PI * i ) / resTheta;
-                    for( int j = 0; j <= resPhi; ++j )
+                    if( analyzed && !( *analyzed )[i] ) continue;
+                    const GlyphFrame& f = frames[i];
+                    if( !f.inside ) continue;
+                    counts.minEval = std::min( counts.minEval, f.l3 );
+                    counts.maxEval = std::max( counts.maxEval, f.l1 );
+                    if( !f.valid() ) { counts.skipped++; continue; }
+                    counts.valid++;
+
+                    // Nearly isotropic background gets no glyph.
+                    double a = anisotropyOf( f, cullByFA );
+                    if( a < minAnisotropy ) { counts.culled++; continue; }
+                    anisotropy.push_back( a );
+
+                    // Optional: scale this glyph so it fits in its cell (no overlap with neighbors).
+                    double scaleFactor = 1.0;
+                    if( normalizeToCell && spacing > 1e-12 )
                     {
-                        double phi = -M_PI / 2.0 + ( M_PI * j ) / resPhi;
-
-                        Point3 unitPos = superquadricPoint( theta, phi, fp.alpha, fp.beta );
-                        Vector3 unitNorm = superquadricNormal( theta, phi, fp.alpha, fp.beta );
-                        unitNorm = normalized( unitNorm );
-
-                // Unit superquadric z-axis → principal eigenvector; scale by eigenvalues
-                Vector3 scaledPos( l2 * unitPos[0], l3 * unitPos[1], l1 * unitPos[2] );
-                        Vector3 scaledNorm( 
-                            ( l2 > 1e-9 ) ? unitNorm[0] / l2 : unitNorm[0],
-                            ( l3 > 1e-9 ) ? unitNorm[1] / l3 : unitNorm[1],
-                            ( l1 > 1e-9 ) ? unitNorm[2] / l1 : unitNorm[2]
-                        );
-
-                        // Rotate into eigenframe (Z→v1)
-                        Vector3 rotPos = scaledPos[0] * v2 + scaledPos[1] * v3 + scaledPos[2] * v1;
-                        Vector3 rotNorm = scaledNorm[0] * v2 + scaledNorm[1] * v3 + scaledNorm[2] * v1;
-
-                        vertices.push_back( p + scaleFactor * glyphScale * rotPos );
-                        normals.push_back( normalized( rotNorm ) );
-                        colors.push_back( glyphColor );
+                        double targetRadius = 0.5 * spacing * cellFill;
+                        scaleFactor = targetRadius / ( glyphScale * f.l1 );
                     }
+                    glyphs.centers.push_back( samplePoints[i] );
+                    glyphs.frames.push_back( f );
+                    glyphs.sizes.push_back( scaleFactor * glyphScale );
+                    glyphs.colors.push_back( glyphColor( f ) );
                 }
-
-                // Connect the vertex grid into triangles (each quad becomes two triangles).
-                for( int i = 0; i < resTheta; ++i )
+            };
+
+            const bool adaptive = options.get< bool >( "Adaptive Resolution" );
+            const size_t maxTriangles = static_cast< size_t >( std::max( 0, options.get< int >( "Max Triangles" ) ) );
+            const bool outputGrid = options.get< bool >( "Output Grid" );
+            mShapes.configure( resTheta, resPhi, shapeTableRes );
+
+            GlyphSet glyphs;
+            std::vector< double > anisotropy;
+            std::unique_ptr< PlyMeshStream > stream;
+            size_t numBrickGlyphs = 0;
+            if( brickSize == 0 )
+            {
+                samples.collect( { { 0, 0, 0 } }, samples.dims, gridPoints, samplePoints, sampleValues );
+                frames.assign( totalSamples, GlyphFrame() );
+
+                // Progressive: coarse-to-fine passes over every 2^pass-th sample per axis, each publishing the glyphs found so
+                // far (budgets shared out by the analyzed fraction); the last pass analyzes the rest and gives the final result.
+                const int passes = std::max( 0, std::min( 8, options.get< int >( "Progressive Passes" ) ) );
+                const double interval = std::max( 0.0, options.get< double >( "Progressive Interval" ) );
+                auto lastPublish = std::chrono::steady_clock::now();
+                std::vector< char > analyzed( passes > 0 ? totalSamples : 0, 0 );
+                size_t numAnalyzed = 0;
+                for( int pass = passes; pass > 0; --pass )
                 {
-                    for( int j = 0; j < resPhi; ++j )
+                    std::vector< size_t > subset;
+                    for( size_t i = 0; i < totalSamples; ++i )
+                        if( !analyzed[i] && samples.onSubLattice( i, size_t( 1 ) << pass ) ) subset.push_back( i );
                     {
-                        size_t i00 = baseIndex + i * ( resPhi + 1 ) + j;
-                        size_t i01 = baseIndex + i * ( resPhi + 1 ) + ( j + 1 );
-                        size_t i10 = baseIndex + ( i + 1 ) * ( resPhi + 1 ) + j;
-                        size_t i11 = baseIndex + ( i + 1 ) * ( resPhi + 1 ) + ( j + 1 );
-
-                        indices.push_back( i00 ); indices.push_back( i01 ); indices.push_back( i10 );
-                        indices.push_back( i01 ); indices.push_back( i11 ); indices.push_back( i10 );
+                        Algorithm::Progress progress( *this, "Analyzing Tensors (pass " + std::to_string( passes - pass + 1 ) + ")", subset.size() );
+                        if( !analyzeFrames( &subset, [&]( size_t done ) { progress = done; } ) ) return;
                     }
+                    for( size_t i : subset ) analyzed[i] = 1;
+                    numAnalyzed += subset.size();
+
+                    // The coarsest pass is always shown; the interval only throttles the refinements after it.
+                    const std::chrono::duration< double > sinceLast = std::chrono::steady_clock::now() - lastPublish;
+                    if( pass < passes && sinceLast.count() < interval ) continue;
+                    GlyphSet partial;
+                    std::vector< double > partialAnisotropy;
+                    SampleStats partialStats;
+                    collectGlyphs( &analyzed, partial, partialAnisotropy, partialStats );
+                    const double fraction = double( numAnalyzed ) / totalSamples;
+                    keepMostAnisotropic( partial, partialAnisotropy, budgetShare( maxGlyphs, fraction ) );
+                    if( partial.frames.empty() ) continue;
+                    publishParameters( partial );
+                    if( generateMesh && !publishMesh( partial, outputGrid, resTheta, resPhi, adaptive, spacing, budgetShare( maxTriangles, fraction ),
+                                                      numThreads, abortFlag ) )
+                        return;
+                    debugLog() << "Pass " << passes - pass + 1 << ": " << partial.frames.size() << " glyphs from " << numAnalyzed << " samples." << std::endl;
+                    lastPublish = std::chrono::steady_clock::now();
                 }
+
+                std::vector< size_t > rest;
+                for( size_t i = 0; i < analyzed.size(); ++i )
+                    if( !analyzed[i] ) rest.push_back( i );
+                {
+                    Algorithm::Progress progress( *this, "Analyzing Tensors", passes > 0 ? rest.size() : totalSamples );
+                    if( !analyzeFrames( passes > 0 ? &rest : nullptr, [&]( size_t done ) { progress = done; } ) ) return;
+                }
+                collectGlyphs( nullptr, glyphs, anisotropy, stats );
+                keepMostAnisotropic( glyphs, anisotropy, maxGlyphs );
+            }
+            else
+            {
+                // One brick at a time: analyze, tessellate and write its mesh before the next brick's samples exist; nothing
+                // is kept across bricks. Max Glyphs and Max Triangles are shared out by each brick's fraction of the samples.
+                stream.reset( new PlyMeshStream( brickFile ) );
+                const size_t numBricks = brickCounts[0] * brickCounts[1] * brickCounts[2];
+                debugLog() << "Brick mode: " << numBricks << " bricks of up to " << brickDims[0] << "x" << brickDims[1] << "x" << brickDims[2]
+                           << " samples." << std::endl;
+
+                Algorithm::Progress progress( *this, "Generating Bricks", numBricks );
+                size_t brick = 0;
+                for( size_t bk = 0; bk < brickCounts[2]; ++bk )
+                    for( size_t bj = 0; bj < brickCounts[1]; ++bj )
+                        for( size_t bi = 0; bi < brickCounts[0]; ++bi, progress = ++brick )
+                        {
+                            const std::array< size_t, 3 > lo = { { bi * brickDims[0], bj * brickDims[1], bk * brickDims[2] } };
+                            std::array< size_t, 3 > hi;
+                            for( int d = 0; d < 3; ++d ) hi[d] = std::min( lo[d] + brickDims[d], samples.dims[d] );
+                            const double fraction = double( ( hi[0] - lo[0] ) * ( hi[1] - lo[1] ) * ( hi[2] - lo[2] ) ) / totalSamples;
+
+                            GlyphSet brickGlyphs;
+                            std::vector< double > brickAnisotropy;
+                            samples.collect( lo, hi, gridPoints, samplePoints, sampleValues );
+                            frames.assign( samplePoints.size(), GlyphFrame() );
+                            if( !analyzeFrames( nullptr, []( size_t ) {} ) ) return;
+                            collectGlyphs( nullptr, brickGlyphs, brickAnisotropy, stats );
+                            keepMostAnisotropic( brickGlyphs, brickAnisotropy, budgetShare( maxGlyphs, fraction ) );
+                            if( brickGlyphs.frames.empty() ) continue;
+
+                            chooseLevels( brickGlyphs, resTheta, resPhi, adaptive, spacing, budgetShare( maxTriangles, fraction ) );
+                            if( !mShapes.assign( brickGlyphs.frames, numThreads, abortFlag ) ) return;
+                            std::vector< PointF< 3 > > brickVertices;
+                            std::vector< VectorF< 3 > > brickNormals;
+                            std::vector< Color > brickColors;
+                            std::vector< unsigned int > brickIndices;
+                            if( !tessellateGlyphs( brickGlyphs, resTheta, resPhi, numThreads, abortFlag, brickVertices, brickNormals, brickColors,
+                                                   brickIndices, []( size_t ) {} ) )
+                                return;
+                            stream->append( brickVertices, brickNormals, brickColors, brickIndices );
+                            numBrickGlyphs += brickGlyphs.frames.size();
+                        }
+                stream->finish();
             }
 
-            debugLog() << "Eigenvalue Range: Min=" << minEval << ", Max=" << maxEval << std::endl;
+            const double maxEval = stats.maxEval;
+            debugLog() << "Eigenvalue Range: Min=" << stats.minEval << ", Max=" << maxEval << std::endl;
             
             // Size Check
             double maxGlyphRadius = maxEval * glyphScale;
@@ -337,23 +980,121 @@ namespace aufgabe4_1
                 debugLog() << "WARNING: Glyphs are larger than spacing. They might overlap significantly." << std::endl;
             }
 
-            debugLog() << "Processed Tensors: " << validTensors << " valid, " << skippedTensors << " skipped (too small)." << std::endl;
-            debugLog() << "Generated Mesh: " << vertices.size() << " vertices, " << indices.size() / 3 << " triangles." << std::endl;
+            debugLog() << "Processed Tensors: " << stats.valid << " valid, " << stats.skipped << " skipped (too small)." << std::endl;
+            if( stats.culled > 0 ) debugLog() << "Culled " << stats.culled << " nearly isotropic tensors." << std::endl;
+            const size_t numGlyphs = stream ? numBrickGlyphs : glyphs.frames.size();
+            debugLog() << "Glyphs: " << numGlyphs << std::endl;
 
-            if( vertices.empty() ) {
+            if( numGlyphs == 0 ) {
                 debugLog() << "No vertices generated!" << std::endl;
                 clearResults(); return;
             }
 
-            // Package vertices and indices as a single grid (mesh) for the renderer.
-            std::pair< Cell::Type, size_t > cellCounts[] = { { Cell::TRIANGLE, indices.size() / 3 } };
-            auto mesh = DomainFactory::makeGrid< 3 >( std::move( vertices ), 1, cellCounts, std::move( indices ) );
-            setResult( "Glyph Mesh", mesh );
+            // Brick mode: the file is the only result, so memory never holds more than one brick.
+            if( stream )
+            {
+                clearResults();
+                debugLog() << "Brick File '" << brickFile << "': " << stream->numVertices() << " vertices, " << stream->numFaces() << " triangles." << std::endl;
+                return;
+            }
+
+            // Parametric output: a few values per glyph instead of a mesh; the renderer tessellates at its own resolution.
+            publishParameters( glyphs );
+
+            if( !generateMesh )
+            {
+                clearResult( "Render Mesh" );
+                clearResult( "Glyph Mesh" );
+                clearResult( "Color" );
+                clearResult( "Normals" );
+                return;
+            }
+
+            publishMesh( glyphs, outputGrid, resTheta, resPhi, adaptive, spacing, maxTriangles, numThreads, abortFlag );
+        }
+
+    private:
+        // Tessellation (pass 2) and mesh outputs: the double-precision Grid with Color/Normals for analysis, or else the render
+        // mesh in its buffer layout (float, 32-bit indices). Only one of them is built. False if aborted.
+        bool publishMesh( GlyphSet& glyphs, bool outputGrid, int resTheta, int resPhi, bool adaptive, double spacing, size_t maxTriangles,
+                          size_t numThreads, const volatile bool& abortFlag )
+        {
+            chooseLevels( glyphs, resTheta, resPhi, adaptive, spacing, maxTriangles );
+            if( !mShapes.assign( glyphs.frames, numThreads, abortFlag ) ) return false;
+            Algorithm::Progress progress( *this, "Generating Glyphs", glyphs.frames.size() );
+            auto onProgress = [&]( size_t done ) { progress = done; };
+            std::vector< Color > colors;
+
+            if( outputGrid )
+            {
+                std::vector< Point3 > vertices;
+                std::vector< Vector3 > normals;
+                std::vector< size_t > indices;
+                if( !tessellateGlyphs( glyphs, resTheta, resPhi, numThreads, abortFlag, vertices, normals, colors, indices, onProgress ) ) return false;
+                logMesh( vertices.size(), indices.size() / 3 );
+
+                // Package vertices and indices as a single grid (mesh) for analysis.
+                std::pair< Cell::Type, size_t > cellCounts[] = { { Cell::TRIANGLE, indices.size() / 3 } };
+                auto mesh = DomainFactory::makeGrid< 3 >( std::move( vertices ), 1, cellCounts, std::move( indices ) );
+                setResult( "Glyph Mesh", mesh );
+
+                // Attach per-vertex color and normal to the mesh.
+                setResult( "Color", fantom::addData( mesh, Grid< 3 >::Points, colors ) );
+                setResult( "Normals", fantom::addData( mesh, Grid< 3 >::Points, normals ) );
+                clearResult( "Render Mesh" );
+                return true;
+            }
+
+            std::vector< PointF< 3 > > vertices;
+            std::vector< VectorF< 3 > > normals;
+            std::vector< unsigned int > indices;
+            if( !tessellateGlyphs( glyphs, resTheta, resPhi, numThreads, abortFlag, vertices, normals, colors, indices, onProgress ) ) return false;
+            logMesh( vertices.size(), indices.size() / 3 );
+            clearResult( "Glyph Mesh" );
+            clearResult( "Color" );
+            clearResult( "Normals" );
+            setResult( "Render Mesh", std::make_shared< const GlyphMesh >( std::move( vertices ), std::move( normals ),
+                                                                            std::move( colors ), std::move( indices ) ) );
+            return true;
+        }
 
-            // Attach per-vertex color and normal to the mesh so the renderer can shade it.
-            setResult( "Color", fantom::addData( mesh, Grid< 3 >::Points, colors ) );
-            setResult( "Normals", fantom::addData( mesh, Grid< 3 >::Points, normals ) );
+        void logMesh( size_t numVertices, size_t numTriangles )
+        {
+            if( mShapes.resolution() > 0 ) debugLog() << "Shape table: " << mShapes.size() << " unit shapes." << std::endl;
+            debugLog() << "Generated Mesh: " << numVertices << " vertices, " << numTriangles << " triangles." << std::endl;
         }
+
+        // Glyph centers with frame (columns = world directions of the unit shape's x, y, z axes: v2, v3, v1), eigenvalues
+        // (l1, l2, l3), shape (alpha, beta), color and size factor (Glyph Scale and cell normalization).
+        void publishParameters( const GlyphSet& glyphs )
+        {
+            const size_t count = glyphs.frames.size();
+            std::vector< Matrix< 3 > > frames( count );
+            std::vector< Vector3 > eigenvalues( count );
+            std::vector< Vector2 > shapes( count );
+            for( size_t g = 0; g < count; ++g )
+            {
+                const GlyphFrame& f = glyphs.frames[g];
+                for( size_t r = 0; r < 3; ++r )
+                {
+                    frames[g]( r, 0 ) = f.v2[r];
+                    frames[g]( r, 1 ) = f.v3[r];
+                    frames[g]( r, 2 ) = f.v1[r];
+                }
+                eigenvalues[g] = Vector3( f.l1, f.l2, f.l3 );
+                shapes[g] = Vector2( f.form.alpha, f.form.beta );
+            }
+
+            auto centers = DomainFactory::makePointSet< 3 >( glyphs.centers );
+            setResult( "Glyph Centers", centers );
+            setResult( "Glyph Frame", fantom::addData( centers, PointSet< 3 >::Points, frames ) );
+            setResult( "Glyph Eigenvalues", fantom::addData( centers, PointSet< 3 >::Points, eigenvalues ) );
+            setResult( "Glyph Shape", fantom::addData( centers, PointSet< 3 >::Points, shapes ) );
+            setResult( "Glyph Color", fantom::addData( centers, PointSet< 3 >::Points, glyphs.colors ) );
+            setResult( "Glyph Size", fantom::addData( centers, PointSet< 3 >::Points, glyphs.sizes ) );
+        }
+
+        UnitShapeTable mShapes;
     };
 
     AlgorithmRegister< SuperquadricTensorGlyphs > registerGlyphs(
@@ -368,9 +1109,23 @@ namespace aufgabe4_1
         {
             Options( fantom::Options::Control& control ) : VisAlgorithm::Options( control )
             {
-                add< Grid< 3 > >( "Grid", "The glyph mesh", Options::REQUIRED );
+                add< GlyphMesh >( "Render Mesh", "Float mesh of the generator, uploaded as is (replaces Grid/Color/Normals)" );
+                add< Grid< 3 > >( "Grid", "The glyph mesh (not needed with Glyph Centers or Render Mesh)" );
                 add< Function< Color > >( "Color", "Color field" );
                 add< Function< Vector3 > >( "Normals", "Normal field (analytic)" );
+                // Parametric glyphs from the generator (replace the mesh inputs above); tessellated here.
+                add< PointSet< 3 > >( "Glyph Centers", "Glyph positions" );
+                add< Function< Matrix< 3 > > >( "Glyph Frame", "Eigenframe per glyph" );
+                add< Function< Vector3 > >( "Glyph Eigenvalues", "Eigenvalues per glyph" );
+                add< Function< Vector2 > >( "Glyph Shape", "Alpha/beta per glyph" );
+                add< Function< Color > >( "Glyph Color", "Color per glyph (else from the main direction)" );
+                add< Function< double > >( "Glyph Size", "Size factor per glyph (else 1)" );
+                add< int >( "Resolution Theta", "Theta resolution for parametric glyphs", 20 );
+                add< int >( "Resolution Phi", "Phi resolution for parametric glyphs", 20 );
+                add< int >( "Shape Table Resolution", "Steps per unit of alpha/beta for shared unit shapes (0 = exact shape per glyph)", 0 );
+                add< bool >( "Adaptive Resolution", "Fewer segments for round and small parametric glyphs", false );
+                add< int >( "Max Triangles", "Triangle budget for parametric glyphs; smallest are coarsened first (0 = no limit)", 0 );
+                add< int >( "Threads", "Worker threads for tessellation (0 = all cores, 1 = serial)", 0 );
             }
         };
 
@@ -386,20 +1141,105 @@ namespace aufgabe4_1
 
         void execute( const Algorithm::Options& options, const volatile bool& abortFlag ) override
         {
-            (void)abortFlag;
             debugLog() << "Starting Superquadric Rendering..." << std::endl;
-            // Input: the mesh (vertices + triangles) produced by the Superquadric Generation algorithm.
+            std::vector< PointF< 3 > > localVertices;
+            std::vector< VectorF< 3 > > localNormals;
+            std::vector< Color > localColors;
+            std::vector< unsigned int > localIndices;
+
+            // Input: the glyph parameters (tessellated here at the requested resolution), else the generator's render mesh
+            // (uploaded from its own arrays, no copy), else its Grid (converted to float buffers).
+            auto renderMesh = options.get< GlyphMesh >( "Render Mesh" );
+            if( options.get< PointSet< 3 > >( "Glyph Centers" ) )
+            {
+                if( !tessellateParameters( options, abortFlag, localVertices, localNormals, localColors, localIndices ) )
+                {
+                    if( !abortFlag ) clearGraphics( "Glyphs" );
+                    return;
+                }
+                renderMesh = nullptr;
+            }
+            else if( renderMesh )
+            {
+                debugLog() << "Using Render Mesh (" << renderMesh->numVertices() << " vertices)." << std::endl;
+            }
+            else if( !readMesh( options, localVertices, localNormals, localColors, localIndices ) ) { clearGraphics( "Glyphs" ); return; }
+            const std::vector< PointF< 3 > >& vertices = renderMesh ? renderMesh->positions() : localVertices;
+            const std::vector< VectorF< 3 > >& normals = renderMesh ? renderMesh->normals() : localNormals;
+            const std::vector< Color >& colors = renderMesh ? renderMesh->colors() : localColors;
+            const std::vector< unsigned int >& indices = renderMesh ? renderMesh->indices() : localIndices;
+
+            if( vertices.empty() ) { clearGraphics( "Glyphs" ); return; }
+
+            // Log bounding box for debugging.
+            PointF<3> minVert = vertices[0];
+            PointF<3> maxVert = vertices[0];
+            for( const auto& v : vertices ) {
+                for( int d=0; d<3; ++d ) {
+                    minVert[d] = std::min( minVert[d], v[d] );
+                    maxVert[d] = std::max( maxVert[d], v[d] );
+                }
+            }
+            debugLog() << "Vertex Bounds: Min=[" << minVert << "], Max=[" << maxVert << "]" << std::endl;
+
+            // Load Phong shader and build one drawable (positions, normals, colors, indices).
+            auto program = makeProgram();
+            if( !program )
+            {
+                debugLog() << "Failed to create shader program!" << std::endl;
+                clearGraphics( "Glyphs" );
+                return;
+            }
+
+            // Single drawable: all glyphs in one triangle mesh, sent to the 3D view.
+            setGraphics( "Glyphs", makeDrawable( program, vertices, normals, colors, indices ) );
+            debugLog() << "Graphics set. Drawing " << indices.size() / 3 << " triangles." << std::endl;
+        }
+
+    private:
+        std::shared_ptr< graphics::ShaderProgram > makeProgram()
+        {
+            auto const& system = graphics::GraphicsSystem::instance();
+            std::string resourcePath = PluginRegistrationService::getInstance().getResourcePath( "utils/Graphics" );
+            if( !resourcePath.empty() && resourcePath.back() != '/' ) resourcePath += "/";
+
+            debugLog() << "Loading shaders from: " << resourcePath << "shader/surface/phong/multiColor/" << std::endl;
+
+            return system.makeProgramFromFiles(
+                resourcePath + "shader/surface/phong/multiColor/vertex.glsl",
+                resourcePath + "shader/surface/phong/multiColor/fragment.glsl"
+            );
+        }
+
+        std::shared_ptr< graphics::Drawable > makeDrawable( const std::shared_ptr< graphics::ShaderProgram >& program,
+                                                            const std::vector< PointF< 3 > >& vertices, const std::vector< VectorF< 3 > >& normals,
+                                                            const std::vector< Color >& colors, const std::vector< unsigned int >& indices )
+        {
+            auto const& system = graphics::GraphicsSystem::instance();
+            auto bs = graphics::computeBoundingSphere( vertices );
+            debugLog() << "Computed Bounding Sphere: Center=[" << bs.center() << "], Radius=" << bs.radius() << std::endl;
+
+            return system.makePrimitive(
+                graphics::PrimitiveConfig{ graphics::RenderPrimitives::TRIANGLES }
+                    .vertexBuffer( "position", system.makeBuffer( vertices ) )
+                    .vertexBuffer( "normal", system.makeBuffer( normals ) )
+                    .vertexBuffer( "color", system.makeBuffer( colors ) )
+                    .indexBuffer( system.makeIndexBuffer( indices ) )
+                    .boundingSphere( bs ),
+                program
+            );
+        }
+
+        // The mesh (vertices + triangles) produced by the Superquadric Generation algorithm, as float buffers.
+        bool readMesh( const Algorithm::Options& options, std::vector< PointF< 3 > >& vertices, std::vector< VectorF< 3 > >& normals,
+                       std::vector< Color >& colors, std::vector< unsigned int >& indices )
+        {
             auto grid = options.get< Grid< 3 > >( "Grid" );
             if( !grid ) { 
                 debugLog() << "No Grid input connected." << std::endl;
-                clearGraphics( "Glyphs" ); return; 
+                return false; 
             }
 
-            std::vector< PointF< 3 > > vertices;
-            std::vector< VectorF< 3 > > normals;
-            std::vector< Color > colors;
-            std::vector< unsigned int > indices;
-
             // Copy mesh vertices to float buffers (graphics API expects float).
             const auto& pts = grid->points();
             debugLog() << "Input Grid points: " << pts.size() << std::endl;
@@ -453,55 +1293,67 @@ namespace aufgabe4_1
                 }
             }
 
-            if( vertices.empty() ) { clearGraphics( "Glyphs" ); return; }
+            return true;
+        }
 
-            // Log bounding box for debugging.
-            PointF<3> minVert = vertices[0];
-            PointF<3> maxVert = vertices[0];
-            for( const auto& v : vertices ) {
-                for( int d=0; d<3; ++d ) {
-                    minVert[d] = std::min( minVert[d], v[d] );
-                    maxVert[d] = std::max( maxVert[d], v[d] );
-                }
+        // Tessellates the generator's glyph parameters. False if inputs are missing or the run was aborted.
+        bool tessellateParameters( const Algorithm::Options& options, const volatile bool& abortFlag, std::vector< PointF< 3 > >& vertices,
+                                   std::vector< VectorF< 3 > >& normals, std::vector< Color >& colors, std::vector< unsigned int >& indices )
+        {
+            auto centers = options.get< PointSet< 3 > >( "Glyph Centers" );
+            auto frameFunc = options.get< Function< Matrix< 3 > > >( "Glyph Frame" );
+            auto eigenFunc = options.get< Function< Vector3 > >( "Glyph Eigenvalues" );
+            auto shapeFunc = options.get< Function< Vector2 > >( "Glyph Shape" );
+            auto colorFunc = options.get< Function< Color > >( "Glyph Color" );
+            auto sizeFunc = options.get< Function< double > >( "Glyph Size" );
+            if( !centers || !frameFunc || !eigenFunc || !shapeFunc )
+            {
+                debugLog() << "Glyph Centers need Glyph Frame, Glyph Eigenvalues and Glyph Shape." << std::endl;
+                return false;
             }
-            debugLog() << "Vertex Bounds: Min=[" << minVert << "], Max=[" << maxVert << "]" << std::endl;
-
-            // Load Phong shader and build one drawable (positions, normals, colors, indices).
-            auto const& system = graphics::GraphicsSystem::instance();
-            std::string resourcePath = PluginRegistrationService::getInstance().getResourcePath( "utils/Graphics" );
-            if( !resourcePath.empty() && resourcePath.back() != '/' ) resourcePath += "/";
-
-            debugLog() << "Loading shaders from: " << resourcePath << "shader/surface/phong/multiColor/" << std::endl;
-
-            auto program = system.makeProgramFromFiles(
-                resourcePath + "shader/surface/phong/multiColor/vertex.glsl",
-                resourcePath + "shader/surface/phong/multiColor/fragment.glsl"
-            );
-
-            if( !program )
+            const size_t count = std::min( { centers->points().size(), frameFunc->values().size(), eigenFunc->values().size(),
+                                             shapeFunc->values().size() } );
+            int resTheta = std::max( 4, options.get< int >( "Resolution Theta" ) );
+            int resPhi = std::max( 4, options.get< int >( "Resolution Phi" ) );
+            debugLog() << "Tessellating " << count << " parametric glyphs at " << resTheta << "x" << resPhi << "." << std::endl;
+
+            GlyphSet glyphs;
+            glyphs.centers.resize( count );
+            glyphs.frames.resize( count );
+            glyphs.sizes.resize( count, 1.0 );
+            glyphs.colors.resize( count );
+            for( size_t g = 0; g < count; ++g )
             {
-                debugLog() << "Failed to create shader program!" << std::endl;
-                clearGraphics( "Glyphs" );
-                return;
+                GlyphFrame& f = glyphs.frames[g];
+                const Matrix< 3 > frame = frameFunc->values()[g];
+                const Vector3 l = eigenFunc->values()[g];
+                const Vector2 form = shapeFunc->values()[g];
+                f.inside = true;
+                f.l1 = l[0];
+                f.l2 = l[1];
+                f.l3 = l[2];
+                f.v2 = Vector3( frame( 0, 0 ), frame( 1, 0 ), frame( 2, 0 ) );
+                f.v3 = Vector3( frame( 0, 1 ), frame( 1, 1 ), frame( 2, 1 ) );
+                f.v1 = Vector3( frame( 0, 2 ), frame( 1, 2 ), frame( 2, 2 ) );
+                f.form = { form[0], form[1] };
+                glyphs.centers[g] = centers->points()[g];
+                if( sizeFunc && g < sizeFunc->values().size() ) glyphs.sizes[g] = sizeFunc->values()[g];
+                glyphs.colors[g] = ( colorFunc && g < colorFunc->values().size() ) ? colorFunc->values()[g] : glyphColor( f );
             }
 
-            auto bs = graphics::computeBoundingSphere( vertices );
-            debugLog() << "Computed Bounding Sphere: Center=[" << bs.center() << "], Radius=" << bs.radius() << std::endl;
+            // Glyph spacing for the adaptive mode (the generator's sampling grid is not known here).
+            chooseLevels( glyphs, resTheta, resPhi, options.get< bool >( "Adaptive Resolution" ), estimateSpacing( glyphs.centers ),
+                          static_cast< size_t >( std::max( 0, options.get< int >( "Max Triangles" ) ) ) );
 
-            // Single drawable: all glyphs in one triangle mesh, sent to the 3D view.
-            auto drawable = system.makePrimitive(
-                graphics::PrimitiveConfig{ graphics::RenderPrimitives::TRIANGLES }
-                    .vertexBuffer( "position", system.makeBuffer( vertices ) )
-                    .vertexBuffer( "normal", system.makeBuffer( normals ) )
-                    .vertexBuffer( "color", system.makeBuffer( colors ) )
-                    .indexBuffer( system.makeIndexBuffer( indices ) )
-                    .boundingSphere( bs ),
-                program
-            );
-
-            setGraphics( "Glyphs", drawable );
-            debugLog() << "Graphics set. Drawing " << indices.size() / 3 << " triangles." << std::endl;
+            const size_t numThreads = resolveThreadCount( options.get< int >( "Threads" ), count, kGlyphChunkSize );
+            mShapes.configure( resTheta, resPhi, std::max( 0, options.get< int >( "Shape Table Resolution" ) ) );
+            if( !mShapes.assign( glyphs.frames, numThreads, abortFlag ) ) return false;
+            Algorithm::Progress progress( *this, "Tessellating Glyphs", count );
+            return tessellateGlyphs( glyphs, resTheta, resPhi, numThreads, abortFlag, vertices, normals, colors, indices,
+                                     [&]( size_t done ) { progress = done; } );
         }
+
+        UnitShapeTable mShapes;
     };
 
     AlgorithmRegister< SuperquadricGlyphRenderer > registerGlyphRenderer(